@@ -0,0 +1,45 @@
+#ifndef CONFIG_WATCHER_HPP
+#define CONFIG_WATCHER_HPP
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "radar_config.hpp"
+
+// How often the watcher thread checks whether it should stop (and, without inotify, the file)
+#define CONFIG_WATCHER_POLL_MS 500
+
+/*
+ * Watches a config file from its own thread. Every change is loaded on top of the last good config
+ * and validated there, a config that passes is published for the acquisition loop to pick up at
+ * the next frame boundary. Publishing is a single atomic pointer exchange, the loop keeps working
+ * on its live config until it takes the new one over.
+ */
+class config_watcher
+{
+    public:
+        config_watcher(const std::string& path, radar_config* current);
+        virtual ~config_watcher();
+
+        // Newest validated config published since the last call, or nullptr. The caller owns it.
+        radar_config* take_pending();
+
+    protected:
+
+    private:
+        std::string m_path;
+
+        // Last good config, only touched by the watcher thread
+        radar_config m_base;
+
+        std::atomic<radar_config*> m_pending;
+
+        std::atomic<bool> m_running;
+        std::thread m_thread;
+
+        void watch_loop();
+        void reload();
+};
+
+#endif //CONFIG_WATCHER_HPP
@@ -0,0 +1,87 @@
+#ifndef CONNECTION_HPP
+#define CONNECTION_HPP
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include "dsp.hpp"
+#include "encoding.hpp"
+#include "json_writer.hpp"
+#include "packet.hpp"
+#include "packet_sink.hpp"
+#include "payload_codec.hpp"
+#include "radar_config.hpp"
+
+/*
+ * One receiver of the output: where it goes, how it is encoded, which dsp stages it wants and how
+ * often. Encoding buffers are kept per connection and reused, and a connection that wants exactly
+ * what another one already encoded this frame sends those bytes instead of encoding them again.
+ */
+class connection
+{
+    public:
+        // Takes ownership of sink. Topics are dsp_stage_t flags, every divisor-th frame is sent.
+        connection(packet_sink* sink, encoding_t encoding, uint32_t topics, uint32_t divisor);
+        virtual ~connection();
+
+        // Binary only, maps and spectra go out lossy compressed within max_error_db, see payload_codec
+        void set_compression(compression_t compression, float max_error_db, float dynamic_range_db);
+
+        // Listeners that may join late, like UDP ones, get the config again every interval_ms
+        void set_config_interval(uint32_t interval_ms);
+
+        // The config is never dropped, the receiver can't make sense of anything else without it
+        void send_config(radar_config* rc);
+        bool config_due();
+
+        bool wants_frame(uint32_t sequence);
+
+        // Sends the last dsp results. When shared already sent this frame with the same encoding and
+        // topics, its bytes are sent as they are. Binary frames are stamped with the message number
+        // of this connection and the send time, documents carry the send time of their encoding.
+        void send_frame(dsp* dsp_chain, uint32_t sequence, uint64_t timestamp_us, bool droppable, connection* shared);
+
+        // Whether send_frame of this connection can be shared with other
+        bool same_output(connection* other);
+
+        packet_sink* get_sink();
+        encoding_t get_encoding();
+        compression_t get_compression();
+        uint32_t get_topics();
+        uint32_t get_divisor();
+
+    protected:
+
+    private:
+        packet_sink* m_sink;
+        encoding_t m_encoding;
+        uint32_t m_topics;
+        uint32_t m_divisor;
+
+        payload_codec* m_codec = nullptr;
+
+        // Frames sent so far
+        uint32_t m_messages = 0;
+
+        uint32_t m_config_interval_us = 0;
+        uint64_t m_last_config_us = 0;
+
+        // Reused for every message
+        packet_writer m_writer;
+        json_writer m_text;
+        std::vector<uint8_t> m_encoded;
+
+        // The last frame as it went out, valid until the next one
+        uint32_t m_length;
+        std::vector<boost::asio::const_buffer> m_frame;
+
+        void encode_frame(dsp* dsp_chain, uint32_t sequence, uint64_t timestamp_us);
+
+        // Length prefixed document
+        void set_document(const uint8_t* data, size_t length, std::vector<boost::asio::const_buffer>* buffers);
+};
+
+#endif //CONNECTION_HPP
@@ -3,6 +3,32 @@
 
 #define MTI_FILTER_TRAIN_FRAMES 5
 
+// Zero uses one dsp thread per available core
+#define DSP_DEFAULT_NUM_THREADS 0
+
+// The RX antennas form an L with RX3 in the corner, RX1 / RX3 share a row and RX2 / RX3 a column
+#define DSP_AZIMUTH_ANTENNA_A 0
+#define DSP_AZIMUTH_ANTENNA_B 2
+#define DSP_ELEVATION_ANTENNA_A 1
+#define DSP_ELEVATION_ANTENNA_B 2
+
+// Parts of the full chain that can be switched off, bit flags
+typedef enum
+{
+    DSP_STAGE_FRAME = 1 << 0,          // Raw samples of the first chirp
+    DSP_STAGE_SLOW_TIME = 1 << 1,      // Slow time transforms around the range of interest
+    DSP_STAGE_TRACKS = 1 << 2,         // Detection and tracking
+    DSP_STAGE_SPECTROGRAM = 1 << 3,    // Micro-Doppler tiles of the presence target
+    DSP_STAGE_AZIMUTH = 1 << 4,        // Range-angle map of the azimuth pair
+    DSP_STAGE_ELEVATION = 1 << 5       // Range-angle map of the elevation pair
+} dsp_stage_t;
+
+#define DSP_DEFAULT_STAGES (DSP_STAGE_FRAME | DSP_STAGE_SLOW_TIME | DSP_STAGE_TRACKS | DSP_STAGE_SPECTROGRAM)
+#define DSP_ALL_STAGES (DSP_DEFAULT_STAGES | DSP_STAGE_AZIMUTH | DSP_STAGE_ELEVATION)
+
+// Spectrogram tiles are sent as bytes rather than dB floats
+#define DSP_SPECTROGRAM_QUANTISED true
+
 #include "ifxRadar_RangeSpectrum.h"
 #include "ifxRadar_MTI.h"
 #include "ifxRadar_Vector.h"
@@ -15,24 +41,82 @@
 
 #include "json.hpp"
 #include "fft_circular.hpp"
+#include "thread_pool.hpp"
+#include "tracker.hpp"
+#include "presence.hpp"
+#include "spectrogram.hpp"
+#include "range_angle.hpp"
+#include "processing_profile.hpp"
+#include "dsp_kernel.hpp"
+#include "packet.hpp"
+#include "payload_codec.hpp"
+#include "slow_time_recorder.hpp"
 
 #include <iostream>
-#include <fstream>
-#include <iomanip>
 
 #include <chrono>
 using namespace std;
 
+#include <memory>
 #include <string>
+#include <vector>
 
 class dsp
 {
     public:
-        dsp(radar_config *radar_config);
+        // Pool workers are pinned to cpus when it isn't empty, see thread_pool
+        dsp(radar_config *radar_config, uint32_t num_threads = DSP_DEFAULT_NUM_THREADS, const std::vector<uint32_t>& cpus = std::vector<uint32_t>());
         virtual ~dsp();
 
+        // True when the SDK couldn't build the profile, the presence tier or the detection handles
+        bool failed();
+        std::string get_error();
+
+        // Same as process followed by create_json
         json run(ifx_Frame_t frame);
 
+        // Runs the chain on one frame, the results are kept until the next one
+        void process(ifx_Frame_t frame);
+
+        // Results of the last processed frame, limited to the stages in topics. Presence is always there.
+        json create_json(uint32_t topics = DSP_ALL_STAGES);
+        // Same document as create_json without building it, see json_writer.hpp
+        void write_json(json_writer* writer, uint32_t topics = DSP_ALL_STAGES);
+        // With a codec the maps and the spectrogram go out compressed
+        void write_packets(packet_writer* writer, uint32_t topics = DSP_ALL_STAGES, payload_codec* codec = nullptr);
+
+        // Schema of the slow-time bins, again whenever the config changed
+        void write_slow_time_schema(slow_time_recorder* recorder);
+        // A row when the last frame ran the slow-time stage, and the spectra whenever they are complete
+        void write_slow_time(slow_time_recorder* recorder, uint32_t sequence, uint64_t timestamp_us);
+
+        // The full chain only runs, and only has something to send, while presence is confirmed
+        bool is_presence_confirmed();
+        bool presence_changed();
+
+        // Scene activity seen by the coarse tier in the last frame
+        bool motion_detected();
+
+        // Wall time spent in the last call to run
+        uint64_t get_last_run_time_us();
+
+        // When the last process finished, see packet_time_us
+        uint64_t get_done_time_us();
+
+        uint32_t get_num_threads();
+
+        // True when the config matches one of DSP_KERNEL_PROFILES
+        bool is_specialised();
+
+        // Any combination of dsp_stage_t, the presence tier always runs
+        void set_stages(uint32_t stages);
+
+        // Stage of a name as used on the command line and by subscribers, e.g. "tracks"
+        static bool parse_stage(const std::string& name, uint32_t* stage);
+
+        // Picks up config changes radar_config::same_dimensions accepts, the profile stays. Anything else needs a new dsp.
+        void update_config();
+
     protected:
 
     private:
@@ -43,6 +127,14 @@ class dsp
             ifx_Vector_R_t fft_spectrum_result;
 
             ifx_Matrix_C_t frame_fft_half_result;
+
+            // Range gated copies of the two above, the rest of the chain only sees these
+            ifx_Vector_R_t gated_spectrum;
+
+            ifx_Matrix_C_t gated_fft;
+
+            // Cleared when the SDK transform of the last frame failed, the gated copies are stale then
+            bool valid;
         } range_spectrum_t;
 
         typedef struct
@@ -61,7 +153,39 @@ class dsp
             ifx_Vector_C_t chirp_fft_result;
         } doppler_fft_t;
 
-        range_spectrum_t m_range_spectrum;
+        // One range transform per antenna, so antennas can be processed in parallel
+        range_spectrum_t* m_range_spectrum;
+
+        uint32_t m_num_antennas;
+
+        // Per antenna views on the gated transforms and spectra, in the form the kernels take them
+        const ifx_Matrix_C_t** m_gated_ffts;
+        const ifx_Vector_R_t** m_gated_spectra;
+
+        // Built for the config. Frames with fewer antennas than configured get a kernel of their own.
+        dsp_kernel* m_kernel;
+        dsp_kernel* m_partial_kernel = nullptr;
+        uint32_t m_partial_num_antennas = 0;
+
+        // Kernel for the frame being processed
+        dsp_kernel* m_active_kernel;
+
+        // Shared with the stages, stays the same for the life of the dsp
+        std::shared_ptr<const processing_profile> m_profile;
+
+        uint32_t m_gate_start;
+        uint32_t m_gate_num_bins;
+
+        // Coherent sum of the gated antenna range transforms, only filled in for the bins of interest
+        ifx_Matrix_C_t m_antenna_sum;
+
+        thread_pool* m_thread_pool;
+
+        uint64_t m_last_run_time_us = 0;
+        uint64_t m_done_time_us = 0;
+
+        // Set when one of the handles below couldn't be created
+        std::string m_error;
 
         mti_t m_mti;
 
@@ -70,9 +194,49 @@ class dsp
 
         doppler_fft_t m_doppler_fft;
 
-        radar_config* m_radar_config;
+        typedef struct
+        {
+            ifx_Peak_Search_Handle_t peak_search_handle;
+
+            ifx_Peak_Search_Result_t peak_search_result;
+        } peak_search_t;
+
+        peak_search_t m_peak_search;
+
+        detection_t m_detections[TRACKER_MAX_DETECTIONS];
+        uint32_t m_num_detections = 0;
+
+        tracker* m_tracker;
+
+        presence* m_presence;
+
+        spectrogram* m_spectrogram;
+
+        uint32_t m_stages = DSP_DEFAULT_STAGES;
 
-        unsigned long int time_stamp;
+        // What the last processed frame produced
+        bool m_coarse_ran = false;
+        bool m_full_ran = false;
+        bool m_frame_valid = false;
+        bool m_tracks_valid = false;
+        bool m_tile_ready = false;
+        bool m_azimuth_valid = false;
+        bool m_elevation_valid = false;
+        bool m_slow_time_valid = false;
+
+        std::vector<float> m_frame_row;
+
+        // Recorder rows and spectra, see write_slow_time
+        std::vector<float> m_slow_time_real;
+        std::vector<float> m_slow_time_imag;
+        std::vector<float> m_slow_time_spectra;
+
+        // The spectrogram tile as floats, for the codec
+        std::vector<float> m_tile;
+        range_angle* m_azimuth_map;
+        range_angle* m_elevation_map;
+
+        radar_config* m_radar_config;
 
         long unsigned int run_count = 0;
 
@@ -84,16 +248,10 @@ class dsp
         /*
          * Doppler FFT related variables
          */
-        fft_circular* fft_handle;
-
-        string file_name;
-
-        ofstream data_file;
+        fft_circular** fft_handle;
 
         fftw_complex integrated[NUM_FFT_POINTS];
 
-        float range_interest = 1.0f;
-
         int num_frames_per_fft;
         int curr_frames_sampled = 0;
 
@@ -109,12 +267,28 @@ class dsp
         void create_doppler_fft_handle();
         void destroy_doppler_fft_handle();
 
+        void create_peak_search_handle();
+        void destroy_peak_search_handle();
+
+        // Sets valid of the antenna, which is all a pool worker can report
+        bool range_transform(ifx_Frame_t* frame, uint32_t antenna);
+        void slow_time_update(uint32_t bin_index);
+
+        void run_full(ifx_Frame_t* frame, uint32_t num_antennas);
+
+        void write_map(packet_writer* writer, packet_type_t type, const float* map, const uint32_t* map_dims, payload_codec* codec);
+
+        // False when an SDK run failed, the frame then has no detections to track
+        bool detect_targets(uint32_t num_antennas);
+        // Leaves the fft shifted Doppler spectrum of a gated bin in m_doppler_fft.chirp_fft_result
+        bool doppler_transform(uint32_t bin);
+        bool estimate_speed(uint32_t bin, float* speed);
+        float estimate_angle(uint32_t num_antennas, uint32_t bin);
+
         float create_scale(ifx_Vector_R_t* win);
         void fft_shift(ifx_Vector_C_t* vector);
 
         void insert_new_sample(ifx_Vector_C_t* new_sample);
-
-        void print_complex(fftw_complex *signal, ofstream &location);
 };
 
 #endif // DSP_HPP
@@ -0,0 +1,49 @@
+#ifndef DSP_KERNEL_HPP
+#define DSP_KERNEL_HPP
+
+#include <stdint.h>
+
+#include "ifxRadar_Matrix.h"
+#include "ifxRadar_Vector.h"
+
+/*
+ * Sensor profiles of the fleet as (samples per chirp, chirps per frame, antennas). Each one gets
+ * its own build of the kernels with every loop bound known at compile time, any other config
+ * runs on the generic build.
+ */
+#define DSP_KERNEL_PROFILES(X) \
+    X(128, 64, 3)   /* conf/config.json */ \
+    X(64, 32, 3)    /* radar_config defaults */
+
+/*
+ * The loops of the dsp chain that don't go through the SDK. Antenna arrays hold the gated range
+ * transforms (chirps x gated bins) or gated amplitude spectra of every antenna, in order.
+ */
+class dsp_kernel
+{
+    public:
+        virtual ~dsp_kernel() {}
+
+        // Copies the detection zone out of a half range transform, chirps x range_fft_size / 2, into gated
+        virtual void gate(const ifx_Matrix_C_t* full, uint32_t gate_start, ifx_Matrix_C_t* gated) = 0;
+
+        // Mean over the antennas, for every bin of mean
+        virtual void mean_spectrum(const ifx_Vector_R_t* const* spectra, ifx_Vector_R_t* mean) = 0;
+
+        // Coherent sum over the antennas of the first chirp of a gated bin
+        virtual ifx_Complex_t antenna_sum(const ifx_Matrix_C_t* const* ffts, uint32_t bin) = 0;
+
+        // Windowed chirps of a gated bin, the input of the Doppler transform
+        virtual void doppler_input(const ifx_Matrix_C_t* fft, uint32_t bin, const float* window, ifx_Complex_t* out) = 0;
+
+        // Strongest bin of a Doppler spectrum twice as long as there are chirps
+        virtual uint32_t doppler_peak(const ifx_Complex_t* spectrum) = 0;
+
+        // False for the generic build
+        virtual bool is_specialised() = 0;
+};
+
+// Specialised build for the given sizes when it is in DSP_KERNEL_PROFILES, generic one otherwise
+dsp_kernel* create_dsp_kernel(uint32_t num_samples, uint32_t num_chirps, uint32_t num_antennas);
+
+#endif //DSP_KERNEL_HPP
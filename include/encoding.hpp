@@ -0,0 +1,34 @@
+#ifndef ENCODING_HPP
+#define ENCODING_HPP
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+/*
+ * Wire encoding of a connection. Binary is the framed protocol of packet.hpp, the others carry the
+ * same documents as the JSON output, each one a 4 byte length followed by the encoded document.
+ * The config packet is JSON text in every encoding and names the encoding of what follows.
+ */
+typedef enum
+{
+    ENCODING_BINARY = 0,
+    ENCODING_JSON,
+    ENCODING_MSGPACK,
+    ENCODING_CBOR,
+    ENCODING_UBJSON
+} encoding_t;
+
+// False for a name that isn't one of binary, json, msgpack, cbor, ubjson
+bool parse_encoding(const std::string& name, encoding_t* encoding);
+const char* get_encoding_name(encoding_t encoding);
+
+// Replaces the contents of out, which keeps its capacity from one packet to the next
+void encode_document(const json& document, encoding_t encoding, std::vector<uint8_t>* out);
+
+#endif //ENCODING_HPP
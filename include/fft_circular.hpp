@@ -9,7 +9,8 @@
 
 class fft_circular {
     public:
-        fft_circular();
+        // The plan is borrowed and must outlive this object
+        fft_circular(fftw_plan plan);
         virtual ~fft_circular();
 
         void sample(ifx_Complex_t element);
@@ -21,7 +22,7 @@ class fft_circular {
         fftw_complex* signal;
         fftw_complex* result;
 
-        fftw_plan plan;
+        fftw_plan m_plan;
 
         uint32_t sample_count = 0;
 
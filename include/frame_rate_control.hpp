@@ -0,0 +1,43 @@
+#ifndef FRAME_RATE_CONTROL_HPP
+#define FRAME_RATE_CONTROL_HPP
+
+#include <stdint.h>
+
+#include "radar_config.hpp"
+
+// Lowest frame rate used for a static scene
+#define FRAME_RATE_IDLE_HZ 4.0f
+// Seconds without motion before the frame rate is halved
+#define FRAME_RATE_IDLE_STEP_S 5.0f
+
+/*
+ * Throttles acquisition while nothing moves. Every FRAME_RATE_IDLE_STEP_S seconds without motion
+ * the frame rate is halved down to FRAME_RATE_IDLE_HZ, any motion goes straight back to the
+ * configured rate so the full dsp chain always runs at the rate it was set up for.
+ */
+class frame_rate_control
+{
+    public:
+        frame_rate_control(radar_config* radar_config);
+        virtual ~frame_rate_control();
+
+        // Called once per frame, returns true when the device has to be reconfigured
+        bool update(bool motion);
+
+        float get_frame_rate();
+
+        // Takes the configured frame rate as the new nominal one
+        void reset();
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        float m_nominal_frame_rate;
+        float m_frame_rate;
+
+        uint32_t m_idle_frames = 0;
+};
+
+#endif //FRAME_RATE_CONTROL_HPP
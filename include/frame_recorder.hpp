@@ -0,0 +1,34 @@
+#ifndef FRAME_RECORDER_HPP
+#define FRAME_RECORDER_HPP
+
+#include <fstream>
+#include <string>
+
+#include "ifxRadar_Frame.h"
+
+#include "radar_config.hpp"
+#include "replay_source.hpp"
+
+// Writes raw frames in the capture format replay_source reads back
+class frame_recorder
+{
+    public:
+        frame_recorder(radar_config* rc);
+        virtual ~frame_recorder();
+
+        bool open(const std::string& path, std::string* error);
+
+        // Frames that don't match the dimensions in the header are skipped
+        void write(ifx_Frame_t* frame);
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        std::ofstream m_file;
+
+        frame_capture_header_t m_header;
+};
+
+#endif //FRAME_RECORDER_HPP
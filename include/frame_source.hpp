@@ -0,0 +1,43 @@
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <chrono>
+
+#include "ifxRadar_Error.h"
+#include "ifxRadar_Frame.h"
+
+/*
+ * Anything the acquisition loop can pull time domain frames from: the radar itself, a recording or
+ * a simulation. Sources that are not a device pace themselves to the configured frame rate unless
+ * pacing is turned off.
+ */
+class frame_source
+{
+    public:
+        frame_source();
+        virtual ~frame_source();
+
+        virtual ifx_Error_t pull_frame() = 0;
+
+        virtual ifx_Frame_t get_frame() = 0;
+
+        // Applies the current radar_config to the source
+        virtual ifx_Error_t reconfigure() = 0;
+
+        // True once the source has nothing more to give
+        virtual bool finished();
+
+        // Without pacing frames come as fast as they can be produced
+        void set_paced(bool paced);
+
+    protected:
+        // Sleeps until one frame period after the previous call
+        void wait_for_next_frame(float frame_rate);
+
+    private:
+        bool m_paced = true;
+
+        std::chrono::steady_clock::time_point m_next_frame;
+};
+
+#endif //FRAME_SOURCE_HPP
@@ -0,0 +1,65 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <stdint.h>
+
+#include <string>
+
+// Deepest nesting of objects and arrays
+#define JSON_WRITER_MAX_DEPTH 16
+
+/*
+ * Writes JSON text straight into a reusable buffer, without building a json document first. The
+ * output is byte for byte what json::dump() gives for the same document, as long as keys are
+ * written in sorted order the way json objects keep them. Floats go through the same Grisu2
+ * conversion as dump(), widened to double first like a json number.
+ */
+class json_writer
+{
+    public:
+        json_writer();
+        virtual ~json_writer();
+
+        // Starts a new document, the buffer keeps its capacity
+        void clear();
+
+        void begin_object();
+        void end_object();
+        void begin_array();
+        void end_array();
+
+        // Inside an object, every value has to be preceded by its key
+        void key(const char* name);
+
+        void value(bool value);
+        void value(float value);
+        void value(uint32_t value);
+        void value(uint64_t value);
+        void value(int32_t value);
+        void value(const char* value);
+
+        // Whole arrays at once
+        void values(const float* values, uint32_t count);
+        void values(const uint8_t* values, uint32_t count);
+
+        const char* get_data();
+        size_t get_size();
+
+    protected:
+
+    private:
+        std::string m_buffer;
+
+        // Whether the container at each level already holds something
+        bool m_has_items[JSON_WRITER_MAX_DEPTH];
+        uint32_t m_depth = 0;
+
+        // Set by key, the value following it needs no comma
+        bool m_after_key = false;
+
+        void separate();
+        void write_unsigned(uint64_t value);
+        void write_float(float value);
+};
+
+#endif //JSON_WRITER_HPP
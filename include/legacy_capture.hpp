@@ -0,0 +1,89 @@
+#ifndef LEGACY_CAPTURE_HPP
+#define LEGACY_CAPTURE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "slow_time_recorder.hpp"
+
+#define LEGACY_CAPTURE_DATA_FILE "data.txt"
+#define LEGACY_CAPTURE_METRICS_FILE "metrics.txt"
+
+// Spacing of the time axis may differ this much from its first step, it was printed with 6 digits
+#define LEGACY_CAPTURE_AXIS_TOLERANCE 1e-4
+
+/*
+ * Parses a number as written by printf / iostreams into the nearest float, and moves text past it.
+ * The first 19 significant digits are used, which is exact for anything that was a float.
+ */
+bool parse_float(const char** text, const char* end, float* value);
+
+/*
+ * A capture directory of the text output dsp used to write: metrics.txt with the range resolution,
+ * range of interest, bin of interest and the time axis, and data.txt with a curr_bin / real / imag
+ * block per bin. The bins were printed again every time the slow-time transforms completed, so a
+ * capture holds one or more passes over the same bins, each as long as the time axis.
+ */
+class legacy_capture
+{
+    public:
+        legacy_capture();
+        virtual ~legacy_capture();
+
+        // Reads and checks both files, anything that doesn't add up fails with the line it is on
+        bool open(const std::string& directory, std::string* error);
+
+        // Writes a schema and every pass as rows, one frame period apart
+        void write_recording(slow_time_recorder* recorder);
+
+        float get_range_resolution();
+        float get_range_interest();
+        uint32_t get_bin_interest();
+        float get_frame_rate();
+
+        uint32_t get_first_bin();
+        uint32_t get_num_bins();
+        uint32_t get_num_points();
+        uint32_t get_num_passes();
+
+        // num_points values of one bin in one pass
+        const float* get_real(uint32_t pass, uint32_t bin_index);
+        const float* get_imag(uint32_t pass, uint32_t bin_index);
+
+        // Bytes of text parsed by open
+        size_t get_text_size();
+
+        // Odd but usable, e.g. a bin of interest outside the recorded bins
+        const std::vector<std::string>& get_warnings();
+
+    protected:
+
+    private:
+        std::string m_directory;
+
+        float m_range_resolution = 0.0f;
+        float m_range_interest = 0.0f;
+        uint32_t m_bin_interest = 0;
+        float m_frame_rate = 0.0f;
+
+        uint32_t m_first_bin = 0;
+        uint32_t m_num_bins = 0;
+        uint32_t m_num_points = 0;
+        uint32_t m_num_passes = 0;
+
+        // Pass-major, then bin-major, num_points values each
+        std::vector<float> m_real;
+        std::vector<float> m_imag;
+
+        size_t m_text_size = 0;
+
+        std::vector<std::string> m_warnings;
+
+        bool read_metrics(const std::string& path, std::string* error);
+        bool read_data(const std::string& path, std::string* error);
+};
+
+#endif //LEGACY_CAPTURE_HPP
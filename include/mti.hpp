@@ -15,6 +15,10 @@ class mti {
         virtual ~mti();
 
         void train_average(ifx_Matrix_C_t* range_fft);
+
+        // Same as train_average for a single bin. Bins own separate buffers so different bins
+        // may be handed to different threads.
+        void train_average_bin(ifx_Matrix_C_t* range_fft, uint32_t bin);
     protected:
     private:
         radar_config* m_radar_config;
@@ -29,7 +33,7 @@ class mti {
         uint32_t m_bin_min;
         uint32_t m_bin_max;
 
-        void train(ifx_Matrix_C_t* range_fft);
+        void train(ifx_Matrix_C_t* range_fft, uint32_t bin);
 };
 
 
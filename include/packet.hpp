@@ -1,36 +1,143 @@
 #ifndef RADAR_SDK_PACKET_HPP
 #define RADAR_SDK_PACKET_HPP
 
+#include <stdint.h>
 
-class packet {
-    pyblic:
-    enum {
-        HEADER_PKT_ID_LENGTH = sizeof(int),
-        HEADER_BODY_LENGTH = sizeof(int),
-        TOTAL_HEADER_LENGTH = HEADER_PKT_ID_LENGTH + HEADER_BODY_LENGTH;
-    };
+#include <string>
+#include <vector>
 
-    enum {
-        MAX_BODY_LENGTH = 2048
-    };
+#include <boost/asio/buffer.hpp>
 
-private:
-    packet(int packet_id) : packet_id(packet_id), body_length(0)
-    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Packets are written in host byte order, which has to be little endian"
+#endif
 
-    }
+// "RDPK" read as a little endian uint32
+#define PACKET_MAGIC 0x4b504452u
+#define PACKET_VERSION 2
 
-    packet(int packet_id, int body_length) : packet_id(packet_id), body_length(body_length)
-    {
+#define PACKET_MAX_DIMS 4
 
-    }
+// Set on the last packet written for a frame
+#define PACKET_FLAG_LAST_OF_FRAME 0x01
 
-    int packet_id;
-    size_t body_length;
+typedef enum
+{
+    PACKET_TYPE_CONFIG = 0,            // JSON text, sent once per connection and after a config change
+    PACKET_TYPE_PRESENCE = 1,          // [present, range]
+    PACKET_TYPE_FRAME = 2,             // Raw samples of the first chirp of antenna 0
+    PACKET_TYPE_TRACKS = 3,            // tracks x [id, range, speed, angle]
+    PACKET_TYPE_SPECTROGRAM = 4,       // columns x Doppler bins, oldest column first
+    PACKET_TYPE_RANGE_ANGLE_AZIMUTH = 5,   // angle bins x range bins
+    PACKET_TYPE_RANGE_ANGLE_ELEVATION = 6
+} packet_type_t;
 
-    char data[HEADER_PKT_ID_LENGTH + HEADER_BODY_LENGTH + MAX_BODY_LENGTH];
+typedef enum
+{
+    PACKET_DTYPE_F32 = 0,
+    PACKET_DTYPE_U8 = 1,
+    PACKET_DTYPE_I16 = 2,
+    PACKET_DTYPE_JSON = 3,            // UTF-8 text, dims[0] is its length
+    PACKET_DTYPE_COMPRESSED = 4       // F32 array of dims packed by payload_codec, see payload_codec.hpp
+} packet_dtype_t;
 
-};
+/*
+ * Every packet on the wire is this header followed by payload_length bytes of payload, all
+ * little endian. Unused dims are 1. Packets of the same frame share sequence and timestamps.
+ *
+ * sequence counts acquired frames, so frames that weren't sent (no presence, divisor) leave gaps.
+ * message counts the frames sent on one connection from 1, a gap there is a lost frame. All times
+ * are steady clock of the sending host, the later ones as offsets from timestamp_us.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;                      // packet_type_t
+    uint8_t dtype;                     // packet_dtype_t
+    uint8_t flags;
+    uint32_t sequence;
+    uint32_t payload_length;
+    uint64_t timestamp_us;             // Frame acquisition, steady clock
+    uint32_t dims[PACKET_MAX_DIMS];
+    uint32_t message;                  // 0 for the config
+    uint32_t dsp_done_us;              // Processing of the frame finished
+    uint32_t send_us;                  // The transport started writing it out
+    uint32_t reserved;
+} packet_header_t;
+
+static_assert(sizeof(packet_header_t) == 56, "packet_header_t must not be padded");
+
+// Steady clock time in the unit of packet_header_t::timestamp_us
+uint64_t packet_time_us();
+
+// Sets send_us in every packet of a contiguous binary message, anything else is left alone
+void packet_stamp_send(uint8_t* message, size_t length, uint64_t send_time_us);
+
+/*
+ * Collects the packets of one frame into one buffer sequence. Headers and small payloads are copied
+ * into a reusable buffer that only grows, large payloads can be referenced where they are so the
+ * writer doesn't copy them. Each sink then takes the sequence with a single copy of its own: the shm
+ * ring into its slot, udp_streamer into its datagrams, packet_sender into its queue.
+ */
+class packet_writer
+{
+    public:
+        packet_writer();
+        virtual ~packet_writer();
+
+        // Drops whatever was written before
+        void begin(uint32_t sequence, uint64_t timestamp_us, uint64_t dsp_done_us = 0);
+
+        void add(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, const void* payload, uint32_t payload_length);
+
+        // Same as add without the writer's copy, payload has to stay valid and unchanged until the sink's send returns
+        void add_reference(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, const void* payload, uint32_t payload_length);
+
+        // Same as add but leaves the payload to the caller, the pointer is valid until the next add
+        void* add_uninitialised(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, uint32_t payload_length);
+
+        void add_json(packet_type_t type, const std::string& text);
 
+        // Flags the last packet written as the end of the frame and lays out the buffers
+        void end();
+
+        // After end, right before the buffers are handed over. Sets message and send_us of every packet.
+        void stamp(uint32_t message, uint64_t send_time_us);
+
+        // Buffer sequence of the frame for boost::asio::write, valid until the next begin
+        const std::vector<boost::asio::const_buffer>& get_buffers();
+        size_t get_size();
+
+    protected:
+
+    private:
+        // A run of m_buffer or a referenced payload, in wire order
+        typedef struct
+        {
+            const uint8_t* reference;          // nullptr for a run of m_buffer
+            size_t offset;
+            size_t length;
+        } segment_t;
+
+        void add_header(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, uint32_t payload_length);
+        void append_owned(size_t length);
+
+        std::vector<uint8_t> m_buffer;
+        size_t m_size = 0;
+
+        std::vector<segment_t> m_segments;
+        std::vector<boost::asio::const_buffer> m_buffers;
+        size_t m_total_size = 0;
+
+        // Start of the header of every packet in m_buffer, the last one is m_last
+        std::vector<size_t> m_headers;
+        size_t m_last = 0;
+        bool m_empty = true;
+
+        uint32_t m_sequence = 0;
+        uint64_t m_timestamp_us = 0;
+        uint64_t m_dsp_done_us = 0;
+};
 
 #endif
@@ -0,0 +1,167 @@
+#ifndef PACKET_SENDER_HPP
+#define PACKET_SENDER_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "packet_sink.hpp"
+
+// Bytes waiting to be sent before the drop policy kicks in, about a second of full frames
+#define PACKET_SENDER_DEFAULT_QUEUE_BYTES (4 * 1024 * 1024)
+
+// Reconnect backoff, doubled after every failed attempt
+#define PACKET_SENDER_RECONNECT_MIN_MS 100
+#define PACKET_SENDER_RECONNECT_MAX_MS 5000
+
+typedef enum
+{
+    TCP_MODE_NODELAY = 0,   // Every write goes out at once
+    TCP_MODE_NAGLE,         // Kernel default, small writes may wait for the ack of the previous one
+    TCP_MODE_CORK           // Every write goes out in full segments, flushed at its end
+} tcp_mode_t;
+
+typedef enum
+{
+    DROP_POLICY_OLDEST = 0, // Make room by dropping the oldest queued frames
+    DROP_POLICY_NEWEST,     // Drop the frame that doesn't fit
+    DROP_POLICY_COALESCE    // Only the newest frame waits, it replaces whatever frame was queued
+} drop_policy_t;
+
+/*
+ * Sends from its own io thread so a slow receiver never holds up acquisition. send copies the
+ * message into a recycled buffer and returns at once, the io thread writes the queue out in order
+ * one async write at a time. That copy is the price of the queue: a frame references dsp buffers
+ * the next frame overwrites, so it can't wait there as a gather list. Only droppable messages count
+ * against the queue limit and only those are ever dropped, the config always goes out.
+ *
+ * With reconnect on, a lost connection doesn't fail the sender. The io thread connects again with
+ * growing backoff while the queue keeps filling under the drop policy, then sends the config, replays
+ * the backlog of recently written messages and carries on with the queue. Messages written just
+ * before the loss may arrive twice, receivers drop what they have by the packet sequence number.
+ */
+class packet_sender : public packet_sink
+{
+    public:
+        packet_sender(tcp_mode_t tcp_mode, drop_policy_t drop_policy, size_t max_queue_bytes);
+        virtual ~packet_sender();
+
+        // Blocking connect, done before anything is sent. An invalid address fails the sender.
+        bool connect(const std::string& host, uint16_t port, unsigned int timeout_ms, std::string* error);
+
+        // Before connect. Up to backlog_bytes of the last written messages are kept for replay.
+        void set_reconnect(size_t backlog_bytes);
+
+        // Keeps trying in the background, for when the first connect failed
+        void start_reconnect();
+
+        // Server side counterpart of connect, takes the next pending connection of acceptor
+        bool accept(boost::asio::ip::tcp::acceptor& acceptor, unsigned int timeout_ms, std::string* error);
+
+        // Blocking read of a length prefixed message from the peer, only before anything is sent. The
+        // whole message has to arrive within timeout_ms, however the peer spreads it out.
+        bool read_message(std::string* message, uint32_t max_length, unsigned int timeout_ms, std::string* error);
+
+        // The buffers are copied before this returns
+        void send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable);
+        void send_config(const std::vector<boost::asio::const_buffer>& buffers);
+
+        bool is_connected();
+
+        // Set once a write failed, nothing is sent after that
+        bool failed();
+        std::string get_error();
+
+        packet_sink_stats_t get_stats();
+
+    protected:
+
+    private:
+        typedef struct
+        {
+            std::vector<uint8_t>* data;
+            bool droppable;
+            bool config;
+        } message_t;
+
+        tcp_mode_t m_tcp_mode;
+        drop_policy_t m_drop_policy;
+        size_t m_max_queue_bytes;
+
+        boost::asio::io_service m_io_service;
+        boost::asio::io_service::work* m_work;
+        boost::asio::ip::tcp::socket m_socket;
+        std::thread m_thread;
+
+        boost::asio::ip::tcp::endpoint m_endpoint;
+        unsigned int m_timeout_ms = 0;
+
+        bool m_reconnect = false;
+        size_t m_max_backlog_bytes = 0;
+
+        // On the io thread only
+        boost::asio::steady_timer m_timer;
+        uint32_t m_backoff_ms = PACKET_SENDER_RECONNECT_MIN_MS;
+
+        // Everything below is shared with the io thread
+        std::mutex m_lock;
+
+        std::deque<message_t> m_queue;
+        size_t m_droppable_bytes = 0;
+        bool m_writing = false;
+
+        // Spent message buffers, reused so a steady stream doesn't allocate
+        std::vector<std::vector<uint8_t>*> m_free;
+
+        // Written messages, oldest first, replayed after a reconnect
+        std::deque<std::vector<uint8_t>*> m_backlog;
+        size_t m_backlog_bytes = 0;
+
+        // The last config, sent first on every new connection
+        std::vector<uint8_t> m_config;
+
+        std::string m_error;
+        std::atomic<bool> m_failed;
+        std::atomic<bool> m_connected;
+
+        std::atomic<uint64_t> m_queued_bytes;
+        std::atomic<uint64_t> m_sent_bytes;
+        std::atomic<uint64_t> m_dropped_bytes;
+        std::atomic<uint64_t> m_dropped_messages;
+        std::atomic<uint64_t> m_reconnects;
+
+        void configure_socket(unsigned int timeout_ms);
+
+        // Fills data from the socket, which has to be non blocking, unless deadline passes first
+        bool read_before(void* data, size_t size, std::chrono::steady_clock::time_point deadline, std::string* error);
+
+        std::vector<uint8_t>* take_buffer();
+
+        void queue(const std::vector<boost::asio::const_buffer>& buffers, bool droppable, bool config);
+
+        // With m_lock held
+        std::vector<uint8_t>* take_free_buffer();
+        void push_front(std::vector<uint8_t>* data, bool droppable, bool config);
+        void drop(std::deque<message_t>::iterator message);
+        bool make_room(size_t length);
+
+        // On the io thread
+        void start_write();
+        void write_done(const boost::system::error_code& error);
+        void set_cork(bool cork);
+
+        void schedule_reconnect();
+        void start_connect(const boost::system::error_code& error);
+        void connect_timeout(const boost::system::error_code& error);
+        void connect_done(const boost::system::error_code& error);
+};
+
+#endif //PACKET_SENDER_HPP
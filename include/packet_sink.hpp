@@ -0,0 +1,42 @@
+#ifndef PACKET_SINK_HPP
+#define PACKET_SINK_HPP
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+typedef struct
+{
+    uint64_t queued_bytes;      // Waiting right now, zero for sinks that don't queue
+    uint64_t sent_bytes;
+    uint64_t dropped_bytes;
+    uint64_t dropped_messages;
+    uint64_t reconnects;        // Zero for sinks that don't reconnect
+} packet_sink_stats_t;
+
+/*
+ * Where finished messages go. A message is a whole binary frame or one length prefixed document,
+ * send never blocks on the receiver and the buffers may be reused once it returns. Droppable
+ * messages may be lost under load, the others (config, presence transitions) may not.
+ */
+class packet_sink
+{
+    public:
+        virtual ~packet_sink() {}
+
+        virtual void send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable) = 0;
+
+        // Sinks that reconnect keep the config and send it again first thing on every new connection
+        virtual void send_config(const std::vector<boost::asio::const_buffer>& buffers) { this->send(buffers, false); }
+
+        // Set once the sink can't send any more
+        virtual bool failed() = 0;
+        virtual std::string get_error() = 0;
+
+        virtual packet_sink_stats_t get_stats() = 0;
+};
+
+#endif //PACKET_SINK_HPP
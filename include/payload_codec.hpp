@@ -0,0 +1,88 @@
+#ifndef PAYLOAD_CODEC_HPP
+#define PAYLOAD_CODEC_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+#define PAYLOAD_CODEC_DEFAULT_MAX_ERROR_DB 0.25f
+#define PAYLOAD_CODEC_DEFAULT_DYNAMIC_RANGE_DB 60.0f
+
+// Values sharing one offset and step
+#define PAYLOAD_CODEC_BLOCK_SIZE 64
+
+// The values were dB already, otherwise they were power and are turned back into power when decoded
+#define PAYLOAD_CODEC_FLAG_DB 0x01
+
+typedef enum
+{
+    COMPRESSION_NONE = 0,
+    COMPRESSION_DB16,       // Up to 65536 levels per block
+    COMPRESSION_DB8         // Up to 256 levels per block
+} compression_t;
+
+bool parse_compression(const std::string& name, compression_t* compression);
+const char* get_compression_name(compression_t compression);
+
+/*
+ * Start of a compressed payload, followed by the float offset_db of every block, the float step_db
+ * of every block, the rice parameter of every block as one byte each padded to 4 bytes, and then a
+ * single bit stream (LSB first) with the rice coded zigzag deltas of the quantised values.
+ */
+typedef struct
+{
+    uint8_t flags;
+    uint8_t bits;               // 8 or 16
+    uint16_t block_size;
+    uint32_t count;             // Decoded values
+    float max_error_db;         // Bound on the error of every value above floor_db
+    float floor_db;             // Everything below was sent as floor_db
+} payload_codec_header_t;
+
+/*
+ * Lossy compression of map and spectrum payloads. Values go to dB, everything more than the dynamic
+ * range below the peak is clamped, every block is quantised with its own offset and a step of at
+ * most twice the error bound, then the deltas between neighbouring values are rice coded. The
+ * synthetic maps of radar_codec_check come out about 4.5 times smaller than the floats at the
+ * default bound and 6.5 times at 1 dB.
+ */
+class payload_codec
+{
+    public:
+        payload_codec(compression_t compression, float max_error_db, float dynamic_range_db);
+        virtual ~payload_codec();
+
+        // values is power unless in_db. The result is valid until the next compress.
+        const std::vector<uint8_t>& compress(const float* values, uint32_t count, bool in_db);
+
+        // Decoded values are dB or power, whatever went in
+        static bool decompress(const uint8_t* data, size_t length, std::vector<float>* values);
+
+        compression_t get_compression();
+
+        // The error actually guaranteed, the requested bound can't be met with too few levels
+        float get_error_bound_db();
+
+        // Declared in the config so receivers know what they are looking at
+        json create_json();
+
+    protected:
+
+    private:
+        compression_t m_compression;
+        uint32_t m_bits;
+        float m_max_error_db;
+        float m_dynamic_range_db;
+
+        std::vector<float> m_db;
+        std::vector<uint32_t> m_residuals;
+        std::vector<uint8_t> m_output;
+};
+
+#endif //PAYLOAD_CODEC_HPP
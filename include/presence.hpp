@@ -0,0 +1,105 @@
+#ifndef PRESENCE_HPP
+#define PRESENCE_HPP
+
+#include "ifxRadar_MTI.h"
+#include "ifxRadar_PeakSearch.h"
+#include "ifxRadar_Vector.h"
+
+#include "radar_config.hpp"
+#include "processing_profile.hpp"
+
+#include <memory>
+#include <string>
+
+#include "json.hpp"
+#include "json_writer.hpp"
+using json = nlohmann::json;
+
+#define PRESENCE_MAX_PEAKS 4
+
+typedef enum
+{
+    PRESENCE_STATE_ABSENT = 0,
+    PRESENCE_STATE_PRESENT
+} presence_state_t;
+
+/*
+ * Coarse presence detector. Works on a single amplitude range spectrum per frame (MTI + peak
+ * search inside the detection zone) so it is cheap enough to run on every frame, and the rest of
+ * the dsp chain only has to run while presence is confirmed.
+ */
+class presence
+{
+    public:
+        presence(radar_config* radar_config, std::shared_ptr<const processing_profile> profile);
+        virtual ~presence();
+
+        // True when the SDK couldn't set up the detector, update then leaves the state alone
+        bool failed();
+        std::string get_error();
+
+        // Feeds the gated amplitude range spectrum of one frame and returns the confirmed state
+        presence_state_t update(ifx_Vector_R_t* range_spectrum);
+
+        presence_state_t get_state();
+
+        // True when the last update flipped the confirmed state
+        bool state_changed();
+
+        // True when the last update saw a peak, confirmed or not
+        bool motion_detected();
+
+        // Range of the last target seen by the coarse detector
+        float get_target_range();
+
+        // Same target as an index into the gated spectrum
+        uint32_t get_target_bin();
+
+        json create_json();
+        void write_json(json_writer* writer);
+
+        // Picks up changed thresholds and MTI weight from the config, the state is kept
+        void update_config();
+
+    protected:
+
+    private:
+        typedef struct
+        {
+            ifx_Peak_Search_Handle_t peak_search_handle;
+
+            ifx_Peak_Search_Result_t peak_search_result;
+        } peak_search_t;
+
+        radar_config* m_radar_config;
+
+        std::shared_ptr<const processing_profile> m_profile;
+
+        std::string m_error;
+
+        ifx_MTI_Handle_t m_mti_handle;
+        ifx_Vector_R_t m_mti_result;
+
+        peak_search_t m_presence_search;
+        peak_search_t m_absence_search;
+
+        presence_state_t m_state = PRESENCE_STATE_ABSENT;
+        bool m_state_changed = false;
+        bool m_motion = false;
+
+        // Consecutive frames disagreeing with the current state
+        uint32_t m_pending_count = 0;
+
+        // Index into the gated spectrum
+        uint32_t m_target_bin = 0;
+
+        void create_handles();
+        void destroy_handles();
+
+        void create_peak_search(peak_search_t* search, float threshold_factor);
+        void destroy_peak_search(peak_search_t* search);
+
+        bool fine_absence_check();
+};
+
+#endif //PRESENCE_HPP
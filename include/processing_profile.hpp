@@ -0,0 +1,98 @@
+#ifndef PROCESSING_PROFILE_HPP
+#define PROCESSING_PROFILE_HPP
+
+#include <stdint.h>
+
+#include <string>
+
+#include <fftw3.h>
+
+#include "radar_config.hpp"
+#include "fft_circular.hpp"
+
+// Range the slow time transforms are centred on, and how many bins either side of it they cover
+#define PROCESSING_PROFILE_RANGE_OF_INTEREST_M 1.0f
+#define PROCESSING_PROFILE_SLOW_TIME_HALF_WIDTH 4
+
+// Angle bins, uniform in sin(angle) over [-1, 1). Same as a zero padded FFT of this size across the pair.
+#define RANGE_ANGLE_NUM_BINS 32
+
+/*
+ * Everything the dsp stages derive from the config, worked out once: axes, bin limits, window and
+ * steering tables and the slow time FFT plan. A profile never changes after it is built, stages
+ * share one through a shared_ptr and may read it from any thread. A changed config gets a new
+ * profile.
+ */
+class processing_profile
+{
+    public:
+        processing_profile(const device_metrics_t* metrics, const ifx_Device_Config_t* device_config);
+        virtual ~processing_profile();
+
+        // The Doppler window of a config, scaled like get_doppler_window. False when the SDK can't build it.
+        static bool create_doppler_window(const device_metrics_t* metrics, uint32_t num_chirps, float* window, std::string* error);
+
+        // Set when a table couldn't be built, the window is then rectangular
+        bool failed() const;
+        std::string get_error() const;
+
+        // Range gate, as bins of the full range transform
+        uint32_t get_gate_start() const;
+        uint32_t get_gate_num_bins() const;
+
+        // Range in m of each gated bin
+        float get_range(uint32_t gated_bin) const;
+        const float* get_range_axis() const;
+
+        // Bins the slow time transforms run on, as bins of the full range transform and inside the gate
+        uint32_t get_bin_of_interest() const;
+        uint32_t get_slow_time_min_bin() const;
+        uint32_t get_slow_time_max_bin() const;
+
+        uint32_t get_num_chirps() const;
+
+        // The Doppler transform is zero padded to twice the number of chirps
+        uint32_t get_num_doppler_bins() const;
+
+        // Speed in m/s of each bin of an fft shifted Doppler spectrum
+        float get_speed(uint32_t doppler_bin) const;
+        const float* get_speed_axis() const;
+
+        // One coefficient per chirp, scaled to a mean of one so levels stay comparable
+        const float* get_doppler_window() const;
+
+        // Steering phase e^(j * pi * sin(angle)) per angle bin
+        const float* get_steering_real() const;
+        const float* get_steering_imag() const;
+
+        // Plan for NUM_FFT_POINTS, run it on fftw_malloc'ed buffers with fftw_execute_dft
+        fftw_plan get_slow_time_plan() const;
+
+    protected:
+
+    private:
+        processing_profile(const processing_profile&) = delete;
+        processing_profile& operator=(const processing_profile&) = delete;
+
+        uint32_t m_gate_start;
+        uint32_t m_gate_num_bins;
+        float* m_range_axis;
+
+        uint32_t m_bin_of_interest;
+        uint32_t m_slow_time_min_bin;
+        uint32_t m_slow_time_max_bin;
+
+        uint32_t m_num_chirps;
+        uint32_t m_num_doppler_bins;
+        float* m_speed_axis;
+        float* m_doppler_window;
+
+        float m_steering_real[RANGE_ANGLE_NUM_BINS];
+        float m_steering_imag[RANGE_ANGLE_NUM_BINS];
+
+        fftw_plan m_slow_time_plan;
+
+        std::string m_error;
+};
+
+#endif //PROCESSING_PROFILE_HPP
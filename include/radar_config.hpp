@@ -9,6 +9,14 @@
 #include "json.hpp"
 using json = nlohmann::json;
 
+#include <memory>
+#include <string>
+
+#define RADAR_CONFIG_DEFAULT_PATH "conf/config.json"
+
+// Slower than this the per-second reports and the MTI history, both sized in frames, get too short
+#define RADAR_CONFIG_MIN_FRAME_RATE 1
+
 typedef struct
 {
     float m_range_resolution;   /**< The range resolution is the distance between two consecutive
@@ -57,11 +65,25 @@ typedef struct
     float m_threshold_factor_absence_peak;
     float m_threshold_factor_absence_fine_peak;
 
+    float m_minimum_detection_range;   /**< Start of the zone searched for presence */
+    float m_maximum_detection_range;   /**< End of the zone searched for presence */
+
+    uint32_t m_range_hysteresis;       /**< Bins either side of the last target searched by the
+                                            fine absence check */
+    uint32_t m_presence_confirm_count; /**< Consecutive detecting frames before presence is reported */
+    uint32_t m_absence_confirm_count;  /**< Consecutive empty frames before absence is reported */
+
     float m_mti_weight;
 
     float m_value_per_bin;
+
+    uint32_t m_range_gate_start_bin;   /**< First range bin inside the detection zone */
+    uint32_t m_range_gate_num_bins;    /**< Number of range bins kept after gating, every stage
+                                            after the range transform works on these only */
 } device_metrics_t;
 
+class processing_profile;
+
 class radar_config
 {
     public:
@@ -74,11 +96,26 @@ class radar_config
 
         json create_json();
 
+        // Only the frame period depends on it, the dimensions stay the same
+        void set_frame_rate(float frame_rate);
+
+        // Applies the IFX_* values of a conf/config.json style file on top of the current ones.
+        // Nothing changes when the file can't be parsed or the result doesn't validate.
+        bool load_file(const std::string& path, std::string* error);
+
+        // True when both configs lead to the same buffer sizes and processing profile in the dsp chain
+        bool same_dimensions(radar_config* other);
+
+        // Derived tables for the dsp stages, built from the current values. Ask again after a change.
+        std::shared_ptr<const processing_profile> create_processing_profile();
+
     protected:
 
     private:
         void compute_metrics();
 
+        bool validate(std::string* error);
+
         // Metrics for device
         device_metrics_t m_device_metrics;
         // SDK Device config structure
@@ -4,8 +4,9 @@
 #include "ifxRadar_DeviceControl.h"
 #include "ifxRadar_Error.h"
 #include "radar_config.hpp"
+#include "frame_source.hpp"
 
-class radar_control
+class radar_control : public frame_source
 {
     public:
         radar_control(radar_config *rc);
@@ -13,6 +14,10 @@ class radar_control
 
         ifx_Error_t pull_frame();
 
+        // Applies the current radar_config to the device. The frame is only reallocated when its
+        // dimensions changed. After a failure pull_frame only returns errors.
+        ifx_Error_t reconfigure();
+
         ifx_Frame_t get_frame();
 
         ifx_Device_Handle_t get_device_handle();
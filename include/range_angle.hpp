@@ -0,0 +1,57 @@
+#ifndef RANGE_ANGLE_HPP
+#define RANGE_ANGLE_HPP
+
+#include <stdint.h>
+
+#include "ifxRadar_Matrix.h"
+
+#include "radar_config.hpp"
+#include "processing_profile.hpp"
+
+#include <memory>
+
+#include "json.hpp"
+#include "json_writer.hpp"
+using json = nlohmann::json;
+
+/*
+ * Range-angle map for one pair of antenna half a wavelength apart. Every range bin of every chirp
+ * is steered to all angle bins with the steering table of the processing profile and the powers are summed over
+ * the chirps. Inputs are split into separate real / imaginary rows first so the inner loop runs
+ * over contiguous range bins and vectorises.
+ */
+class range_angle
+{
+    public:
+        // Covers every gated range bin of the profile
+        range_angle(radar_config* radar_config, std::shared_ptr<const processing_profile> profile);
+        virtual ~range_angle();
+
+        // Both matrices are chirps x range bins, b is the antenna the steering phase is applied to
+        void run(const ifx_Matrix_C_t* a, const ifx_Matrix_C_t* b);
+
+        // RANGE_ANGLE_NUM_BINS rows of num_range_bins powers
+        const float* get_map();
+
+        json create_json();
+        void write_json(json_writer* writer);
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        std::shared_ptr<const processing_profile> m_profile;
+
+        uint32_t m_num_range_bins;
+
+        // One chirp of each antenna, split in real and imaginary rows
+        float* m_a_real;
+        float* m_a_imag;
+        float* m_b_real;
+        float* m_b_imag;
+
+        float* m_map;
+};
+
+#endif //RANGE_ANGLE_HPP
@@ -0,0 +1,73 @@
+#ifndef REPLAY_SOURCE_HPP
+#define REPLAY_SOURCE_HPP
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+
+#include "frame_source.hpp"
+#include "radar_config.hpp"
+
+#define FRAME_CAPTURE_MAGIC "RFRM"
+#define FRAME_CAPTURE_VERSION 1
+
+/*
+ * Raw frame capture as written by frame_recorder: this header, then every frame as num_rx x
+ * num_chirps x num_samples floats. Everything is little endian, like the Pi writing it.
+ */
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t num_rx;
+    uint32_t num_chirps;
+    uint32_t num_samples;
+    float frame_rate;
+} frame_capture_header_t;
+
+/*
+ * Plays back a raw frame capture. The capture has to match the dimensions of the current config,
+ * the dsp chain is sized from the config and not from the file.
+ */
+class replay_source : public frame_source
+{
+    public:
+        replay_source(radar_config* rc);
+        virtual ~replay_source();
+
+        // Fails when the file can't be read or doesn't match the config
+        bool open(const std::string& path, std::string* error);
+
+        // Starts over at the first frame instead of finishing
+        void set_loop(bool loop);
+
+        ifx_Error_t pull_frame();
+
+        ifx_Frame_t get_frame();
+
+        // Only accepts configs with the dimensions of the capture
+        ifx_Error_t reconfigure();
+
+        bool finished();
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        std::ifstream m_file;
+
+        frame_capture_header_t m_header;
+
+        ifx_Frame_t m_frame;
+        bool m_frame_valid = false;
+
+        bool m_loop = false;
+        bool m_finished = true;
+
+        bool matches_config();
+        bool read_frame();
+};
+
+#endif //REPLAY_SOURCE_HPP
@@ -0,0 +1,150 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include "packet_sink.hpp"
+
+// "RDSH" read as a little endian uint32
+#define SHM_RING_MAGIC 0x48534452u
+#define SHM_RING_VERSION 2
+
+#define SHM_RING_DEFAULT_NAME "/radar_sdk"
+// Has to be a power of two
+#define SHM_RING_DEFAULT_SLOTS 16
+// Largest message that fits a slot, a full frame with both range-angle maps is far below that
+#define SHM_RING_DEFAULT_SLOT_BYTES (256 * 1024)
+// Readers attach at any time, the config is repeated so they don't wait long for it
+#define SHM_RING_CONFIG_INTERVAL_MS 1000
+// Silence after which a reader looks whether a writer that died left a new ring under the name
+#define SHM_RING_STALE_MS 2000
+
+/*
+ * Shared memory layout: one shm_ring_header_t, then num_slots slots of slot_stride bytes, each a
+ * shm_ring_slot_t followed by the message. Message n goes to slot n % num_slots. The writer never
+ * waits for readers, a slot is guarded by its state instead: 2n + 1 while message n is written,
+ * 2n + 2 once it is complete. A reader that finds anything else there was lapped.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_slots;
+    uint32_t slot_size;                // Message bytes a slot can hold
+    uint32_t slot_stride;
+
+    std::atomic<uint32_t> head;        // Messages published so far
+    std::atomic<uint32_t> notify;      // Futex word, bumped with every message
+    std::atomic<uint32_t> waiters;     // Readers sleeping on notify, the writer only wakes when there are any
+    std::atomic<uint32_t> closed;      // Set by the writer on its way out, nothing is published after
+} shm_ring_header_t;
+
+typedef struct
+{
+    std::atomic<uint32_t> state;
+    uint32_t length;
+} shm_ring_slot_t;
+
+/*
+ * Producer side, the process that creates the ring and removes it again. Messages are copied into
+ * their slot once, straight from the message buffers. Messages that don't fit a slot are dropped.
+ */
+class shm_ring_writer : public packet_sink
+{
+    public:
+        shm_ring_writer(const std::string& name, uint32_t num_slots, uint32_t slot_size);
+        virtual ~shm_ring_writer();
+
+        bool open(std::string* error);
+
+        void send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable);
+
+        bool failed();
+        std::string get_error();
+
+        packet_sink_stats_t get_stats();
+
+    protected:
+
+    private:
+        std::string m_name;
+        uint32_t m_num_slots;
+        uint32_t m_slot_size;
+
+        uint8_t* m_memory = nullptr;
+        size_t m_size = 0;
+
+        shm_ring_header_t* m_header = nullptr;
+
+        uint32_t m_head = 0;
+
+        uint64_t m_sent_bytes = 0;
+        uint64_t m_dropped_bytes = 0;
+        uint64_t m_dropped_messages = 0;
+
+        shm_ring_slot_t* get_slot(uint32_t message);
+};
+
+typedef enum
+{
+    SHM_RING_OK = 0,
+    SHM_RING_TIMEOUT,
+    SHM_RING_CLOSED                    // Everything was read and the writer is gone, open again for the next one
+} shm_ring_status_t;
+
+/*
+ * Consumer side, any number of them. next hands out a pointer into the ring, nothing is copied and
+ * no syscall is made while messages keep coming. The message can be overwritten by the writer at
+ * any time, so whatever was taken from it only counts once validate says it is still intact.
+ */
+class shm_ring_reader
+{
+    public:
+        shm_ring_reader(const std::string& name);
+        virtual ~shm_ring_reader();
+
+        // Only messages published after open are read, an open reader switches to the current ring
+        bool open(std::string* error);
+
+        // Next message, or SHM_RING_TIMEOUT when none came within timeout_ms
+        shm_ring_status_t next(const uint8_t** data, size_t* length, uint32_t timeout_ms);
+
+        // True when the name now belongs to another ring, which is how a writer that crashed shows
+        bool replaced();
+
+        // False when the message handed out by the last next was overwritten meanwhile
+        bool validate();
+
+        // Messages the writer got past before they were read
+        uint64_t get_lost();
+
+    protected:
+
+    private:
+        std::string m_name;
+
+        uint8_t* m_memory = nullptr;
+        size_t m_size = 0;
+
+        shm_ring_header_t* m_header = nullptr;
+
+        // Of the ring that is mapped
+        uint64_t m_device = 0;
+        uint64_t m_inode = 0;
+
+        uint32_t m_next = 0;
+        uint32_t m_current = 0;
+
+        uint64_t m_lost = 0;
+
+        shm_ring_slot_t* get_slot(uint32_t message);
+};
+
+#endif //SHM_RING_HPP
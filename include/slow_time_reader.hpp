@@ -0,0 +1,51 @@
+#ifndef SLOW_TIME_READER_HPP
+#define SLOW_TIME_READER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "slow_time_recorder.hpp"
+
+// The rows of one schema, every bin series num_rows long
+typedef struct
+{
+    json metrics;
+    uint32_t first_bin;
+    uint32_t num_bins;
+    uint32_t num_points;
+    uint32_t num_rows;
+
+    std::vector<uint64_t> timestamps_us;
+    std::vector<uint32_t> sequences;
+
+    // Bin-major, num_rows values per bin
+    std::vector<float> real;
+    std::vector<float> imag;
+
+    uint32_t num_spectra;
+} slow_time_segment_t;
+
+// Loads a whole slow_time_recorder file. A chunk still being written at the end is left out.
+class slow_time_reader
+{
+    public:
+        slow_time_reader();
+        virtual ~slow_time_reader();
+
+        bool open(const std::string& path, std::string* error);
+
+        const std::vector<slow_time_segment_t>& get_segments();
+
+        // The segment with the most rows, nullptr when there are none
+        const slow_time_segment_t* get_longest_segment();
+
+    protected:
+
+    private:
+        std::vector<slow_time_segment_t> m_segments;
+};
+
+#endif //SLOW_TIME_READER_HPP
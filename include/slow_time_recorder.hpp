@@ -0,0 +1,112 @@
+#ifndef SLOW_TIME_RECORDER_HPP
+#define SLOW_TIME_RECORDER_HPP
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+#define SLOW_TIME_RECORDING_MAGIC "RDST"
+#define SLOW_TIME_RECORDING_VERSION 1
+
+// Rows kept in memory before they go out as one chunk, two seconds at 32 Hz
+#define SLOW_TIME_RECORDER_DEFAULT_CHUNK_ROWS 64
+
+/*
+ * A recording is this header followed by chunks, each a slow_time_chunk_header_t and length bytes of
+ * payload. Chunks are only ever appended, a reader stops at the first one that isn't complete yet.
+ */
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+} slow_time_file_header_t;
+
+typedef enum
+{
+    // JSON text with the metrics, the bins and the columns. Applies to the chunks up to the next one.
+    SLOW_TIME_CHUNK_SCHEMA = 1,
+    // slow_time_rows_header_t, then every column of the schema for all rows, see below
+    SLOW_TIME_CHUNK_ROWS = 2,
+    // slow_time_spectra_header_t, then the float magnitude spectrum of every bin, one after the other
+    SLOW_TIME_CHUNK_SPECTRA = 3
+} slow_time_chunk_type_t;
+
+typedef struct
+{
+    uint32_t type;
+    uint32_t length;
+} slow_time_chunk_header_t;
+
+/*
+ * A column of width w is stored as w series of num_rows values, so every bin of real and imag is
+ * one contiguous slow-time series. Columns follow each other in schema order.
+ */
+typedef struct
+{
+    uint32_t num_rows;
+    uint32_t reserved;
+} slow_time_rows_header_t;
+
+typedef struct
+{
+    uint64_t timestamp_us;
+    uint32_t sequence;
+    uint32_t num_points;
+} slow_time_spectra_header_t;
+
+/*
+ * Writes the slow-time series of the bins around the range of interest, their spectra and the
+ * metrics needed to interpret them. A row costs a few bytes per bin and is only buffered, so this
+ * can stay on for as long as the radar runs.
+ */
+class slow_time_recorder
+{
+    public:
+        slow_time_recorder(uint32_t chunk_rows = SLOW_TIME_RECORDER_DEFAULT_CHUNK_ROWS);
+        virtual ~slow_time_recorder();
+
+        // An existing recording is appended to, a partial chunk left by a crash is cut off first
+        bool open(const std::string& path, std::string* error);
+
+        // Starts a new schema, rows and spectra from here on have num_bins bins from first_bin on
+        void begin(const json& metrics, uint32_t first_bin, uint32_t num_bins, uint32_t num_points);
+
+        // One value per bin in real and imag
+        void add_row(uint64_t timestamp_us, uint32_t sequence, const float* real, const float* imag);
+
+        // num_points magnitudes per bin, bin after bin. Written straight away, spectra are rare.
+        void add_spectra(uint64_t timestamp_us, uint32_t sequence, const float* magnitudes);
+
+        // Writes the buffered rows as a chunk
+        void flush();
+
+        uint32_t get_num_bins();
+
+    protected:
+
+    private:
+        uint32_t m_chunk_rows;
+
+        std::ofstream m_file;
+
+        uint32_t m_num_bins = 0;
+        uint32_t m_num_points = 0;
+        uint32_t m_num_rows = 0;
+
+        // Bin-major, chunk_rows values per bin, as they go into the file
+        std::vector<uint64_t> m_timestamps;
+        std::vector<uint32_t> m_sequences;
+        std::vector<float> m_real;
+        std::vector<float> m_imag;
+
+        void write_chunk_header(slow_time_chunk_type_t type, size_t length);
+        void write_column(const float* column);
+};
+
+#endif //SLOW_TIME_RECORDER_HPP
@@ -0,0 +1,72 @@
+#ifndef SPECTROGRAM_HPP
+#define SPECTROGRAM_HPP
+
+#include <stdint.h>
+
+#include "ifxRadar_Vector.h"
+
+#include "radar_config.hpp"
+
+#include "json.hpp"
+#include "json_writer.hpp"
+using json = nlohmann::json;
+
+// Frames of history held in the image
+#define SPECTROGRAM_NUM_COLUMNS 32
+// A tile is handed out every this many frames
+#define SPECTROGRAM_HOP 16
+// Quantised tiles span this many dB below their peak
+#define SPECTROGRAM_DYNAMIC_RANGE_DB 60.0f
+
+/*
+ * Rolling micro-Doppler image (time x Doppler) of a single range bin. Each frame adds one column
+ * to a ring buffer, nothing already in the image is recomputed. Tiles are read out oldest column
+ * first with a fixed size of SPECTROGRAM_NUM_COLUMNS x Doppler bins.
+ */
+class spectrogram
+{
+    public:
+        spectrogram(radar_config* radar_config, uint32_t num_rows);
+        virtual ~spectrogram();
+
+        // Takes an fft shifted Doppler spectrum, length must match num_rows
+        void add_column(const ifx_Vector_C_t* doppler_spectrum);
+
+        void reset();
+
+        // True once the image is full and another SPECTROGRAM_HOP columns went in
+        bool tile_ready();
+
+        // Copies the image in dB, column after column, oldest first
+        void get_tile(float* tile);
+
+        // Same as get_tile scaled to 0..255 over SPECTROGRAM_DYNAMIC_RANGE_DB below the tile peak
+        void get_tile_quantised(uint8_t* tile);
+
+        uint32_t get_num_rows();
+        uint32_t get_num_columns();
+
+        json create_json(bool quantised);
+        void write_json(json_writer* writer, bool quantised);
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        uint32_t m_num_rows;
+
+        // SPECTROGRAM_NUM_COLUMNS columns of m_num_rows values, in dB
+        float* m_image;
+
+        // Read out buffers for the json tiles, so writing one doesn't allocate
+        float* m_tile;
+        uint8_t* m_tile_quantised;
+
+        // Column written next, also the oldest one once the image is full
+        uint32_t m_head = 0;
+        uint32_t m_filled = 0;
+        uint32_t m_since_tile = 0;
+};
+
+#endif //SPECTROGRAM_HPP
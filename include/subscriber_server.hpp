@@ -0,0 +1,80 @@
+#ifndef SUBSCRIBER_SERVER_HPP
+#define SUBSCRIBER_SERVER_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "connection.hpp"
+#include "packet_sender.hpp"
+
+// How often the accept thread checks for new subscribers and whether it should stop
+#define SUBSCRIBER_SERVER_POLL_MS 100
+
+// A subscription request longer than this is refused
+#define SUBSCRIBER_SERVER_MAX_REQUEST 4096
+
+// A subscriber gets this long for its request. Requests are read on the accept thread, so a silent
+// one holds up the subscribers behind it no longer than this.
+#define SUBSCRIBER_SERVER_REQUEST_TIMEOUT_MS 500
+
+/*
+ * Listens for subscribers from its own thread. A subscriber connects and sends its subscription as
+ * a length prefixed JSON document, all fields optional:
+ *
+ *     {"topics": ["tracks", "spectrogram"], "divisor": 2, "encoding": "binary", "compression": "db8"}
+ *
+ * Topics are dsp stage names, see dsp::parse_stage, and default to DSP_DEFAULT_STAGES. Every
+ * divisor-th frame is sent. Compression uses the bounds of set_compression_bounds. A subscriber
+ * with a bad request is closed again. Accepted subscribers are handed to the acquisition loop,
+ * which picks them up at the next frame boundary.
+ */
+class subscriber_server
+{
+    public:
+        subscriber_server(uint16_t port, tcp_mode_t tcp_mode, drop_policy_t drop_policy, size_t max_queue_bytes, unsigned int timeout_ms);
+        virtual ~subscriber_server();
+
+        // Error bounds for subscribers that ask for compression, before open
+        void set_compression_bounds(float max_error_db, float dynamic_range_db);
+
+        // Starts listening, false with error set when the port can't be had
+        bool open(std::string* error);
+
+        // Subscribers accepted since the last call, the caller owns them
+        std::vector<connection*> take_new();
+
+    protected:
+
+    private:
+        uint16_t m_port;
+        tcp_mode_t m_tcp_mode;
+        drop_policy_t m_drop_policy;
+        size_t m_max_queue_bytes;
+        unsigned int m_timeout_ms;
+
+        float m_max_error_db = PAYLOAD_CODEC_DEFAULT_MAX_ERROR_DB;
+        float m_dynamic_range_db = PAYLOAD_CODEC_DEFAULT_DYNAMIC_RANGE_DB;
+
+        boost::asio::io_service m_io_service;
+        boost::asio::ip::tcp::acceptor m_acceptor;
+
+        std::mutex m_lock;
+        std::vector<connection*> m_new;
+
+        std::atomic<bool> m_running;
+        std::thread m_thread;
+
+        void accept_loop();
+
+        // Reads and checks the request of a freshly accepted subscriber
+        connection* subscribe(packet_sender* sender);
+};
+
+#endif //SUBSCRIBER_SERVER_HPP
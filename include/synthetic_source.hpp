@@ -0,0 +1,62 @@
+#ifndef SYNTHETIC_SOURCE_HPP
+#define SYNTHETIC_SOURCE_HPP
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+
+#include "frame_source.hpp"
+#include "radar_config.hpp"
+
+// Simulated point target, vibrating along the line of sight
+#define SYNTHETIC_TARGET_RANGE_M 1.0f
+#define SYNTHETIC_TARGET_AZIMUTH_RAD 0.35f
+#define SYNTHETIC_TARGET_ELEVATION_RAD 0.0f
+#define SYNTHETIC_VIBRATION_AMPLITUDE_M 0.001f
+#define SYNTHETIC_VIBRATION_FREQUENCY_HZ 2.0f
+
+// In ADC units, the device delivers samples between 0 and 1
+#define SYNTHETIC_SIGNAL_OFFSET 0.5f
+#define SYNTHETIC_SIGNAL_AMPLITUDE 0.05f
+#define SYNTHETIC_NOISE_SIGMA 0.002f
+
+// Fixed so runs can be compared with each other
+#define SYNTHETIC_NOISE_SEED 1
+
+/*
+ * Generates the IF signal of a single point target for the current config, so the whole chain can
+ * be run and benchmarked without a device attached.
+ */
+class synthetic_source : public frame_source
+{
+    public:
+        synthetic_source(radar_config* rc);
+        virtual ~synthetic_source();
+
+        // Fails when the frame for the config can't be allocated
+        bool open(std::string* error);
+
+        ifx_Error_t pull_frame();
+
+        ifx_Frame_t get_frame();
+
+        ifx_Error_t reconfigure();
+
+    protected:
+
+    private:
+        radar_config* m_radar_config;
+
+        ifx_Frame_t m_frame;
+
+        // Acquisition time of the current frame
+        double m_time_s = 0.0;
+
+        std::minstd_rand m_generator;
+        std::normal_distribution<float> m_noise;
+
+        ifx_Error_t create_frame();
+};
+
+#endif //SYNTHETIC_SOURCE_HPP
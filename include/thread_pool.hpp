@@ -0,0 +1,70 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Small work stealing pool used by the dsp chain. A batch of indexed tasks is spread over one
+ * queue per worker, every worker drains its own queue from the back and steals from the front
+ * of the others once it runs dry. The thread that submits a batch works as worker 0 and only
+ * returns once every task of the batch has finished, so the join is deterministic.
+ */
+class thread_pool
+{
+    public:
+        // Zero threads means one per available core. Worker i is pinned to cpus[i % cpus.size()] when
+        // cpus isn't empty, worker 0 is the submitting thread and is left alone.
+        thread_pool(uint32_t num_threads, const std::vector<uint32_t>& cpus = std::vector<uint32_t>());
+        virtual ~thread_pool();
+
+        // Runs task(0) ... task(count - 1) on the pool and blocks until all of them are done
+        void run_batch(uint32_t count, const std::function<void(uint32_t)>& task);
+
+        uint32_t get_num_threads();
+
+        // Restricts the calling thread to one cpu, false where that isn't supported
+        static bool pin_current_thread(uint32_t cpu);
+
+    protected:
+
+    private:
+        typedef struct
+        {
+            std::mutex lock;
+            std::deque<uint32_t> tasks;
+        } worker_queue_t;
+
+        uint32_t m_num_threads;
+
+        worker_queue_t* m_queues;
+
+        std::vector<std::thread> m_workers;
+
+        // Only one batch may be in flight at a time
+        std::mutex m_batch_lock;
+
+        std::mutex m_state_lock;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+
+        bool m_running = true;
+        uint64_t m_generation = 0;
+
+        const std::function<void(uint32_t)>* m_task = nullptr;
+        std::atomic<uint32_t> m_remaining;
+
+        bool pop_task(uint32_t worker, uint32_t* index);
+
+        void work(uint32_t worker);
+        void worker_loop(uint32_t worker);
+};
+
+#endif //THREAD_POOL_HPP
@@ -0,0 +1,110 @@
+#ifndef TRACKER_HPP
+#define TRACKER_HPP
+
+#include <stdint.h>
+
+#include "radar_config.hpp"
+
+#include "json.hpp"
+#include "json_writer.hpp"
+using json = nlohmann::json;
+
+// Track and detection storage is fixed so a frame never allocates
+#define TRACKER_MAX_TRACKS 64
+#define TRACKER_MAX_DETECTIONS 16
+
+// Chi square gate for three measured values (range, speed, angle), 99%
+#define TRACKER_GATE 11.34f
+
+// Hits needed before a tentative track is reported
+#define TRACKER_CONFIRM_HITS 3
+// Consecutive misses before a confirmed track is dropped, tentative tracks die on their first miss
+#define TRACKER_MAX_MISSES 5
+
+typedef struct
+{
+    float range;   // m
+    float speed;   // m/s, radial
+    float angle;   // rad
+} detection_t;
+
+typedef struct
+{
+    uint32_t id;
+
+    // Constant velocity filter over range, measured by range and Doppler
+    float range_state[2];
+    float range_cov[2][2];
+
+    // Constant velocity filter over angle, measured by angle only
+    float angle_state[2];
+    float angle_cov[2][2];
+
+    uint32_t hits;
+    uint32_t misses;
+
+    bool confirmed;
+    bool active;
+} track_t;
+
+class tracker
+{
+    public:
+        tracker(radar_config* radar_config);
+        virtual ~tracker();
+
+        // Advances every track by dt seconds and associates this frame's detections with them
+        void update(const detection_t* detections, uint32_t num_detections, float dt);
+
+        // Drops every track
+        void reset();
+
+        // Picks up changed resolutions from the config
+        void update_config();
+
+        uint32_t get_num_confirmed();
+
+        // Confirmed tracks as [id, range, speed, angle]
+        json create_json();
+        void write_json(json_writer* writer);
+
+        // Same rows as create_json, up to max_tracks of them, returns how many were written
+        uint32_t get_confirmed(float* rows, uint32_t max_tracks);
+
+    protected:
+
+    private:
+        typedef struct
+        {
+            float distance;
+            uint32_t track;
+            uint32_t detection;
+        } association_t;
+
+        radar_config* m_radar_config;
+
+        track_t m_tracks[TRACKER_MAX_TRACKS];
+
+        // Scratch space for the association step
+        association_t m_pairs[TRACKER_MAX_TRACKS * TRACKER_MAX_DETECTIONS];
+        bool m_track_used[TRACKER_MAX_TRACKS];
+        bool m_detection_used[TRACKER_MAX_DETECTIONS];
+
+        uint32_t m_next_id = 0;
+
+        // Measurement variances
+        float m_range_var;
+        float m_speed_var;
+        float m_angle_var;
+
+        // Process noise, as acceleration variances
+        float m_range_accel_var;
+        float m_angle_accel_var;
+
+        void predict(track_t* track, float dt);
+        float distance(const track_t* track, const detection_t* detection);
+        void correct(track_t* track, const detection_t* detection);
+        void birth(const detection_t* detection);
+};
+
+#endif //TRACKER_HPP
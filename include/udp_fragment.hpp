@@ -0,0 +1,30 @@
+#ifndef UDP_FRAGMENT_HPP
+#define UDP_FRAGMENT_HPP
+
+#include <stdint.h>
+
+// "RDUF" read as a little endian uint32
+#define UDP_FRAGMENT_MAGIC 0x46554452u
+
+#define UDP_DEFAULT_MTU 1500
+// IPv4 and UDP headers, what is left of the MTU goes to the fragment
+#define UDP_IP_OVERHEAD 28
+
+/*
+ * Every datagram is this header followed by bytes [offset, offset + payload) of one message, where
+ * a message is exactly what would go over TCP: a binary frame or a length prefixed document. All
+ * fragments of a message but the last one carry the same amount of payload. Little endian.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t message;              // Counts every message sent, gaps are lost messages
+    uint32_t message_length;
+    uint32_t offset;               // Of this fragment's payload in the message
+    uint16_t fragment;
+    uint16_t num_fragments;
+} udp_fragment_header_t;
+
+static_assert(sizeof(udp_fragment_header_t) == 20, "udp_fragment_header_t must not be padded");
+
+#endif //UDP_FRAGMENT_HPP
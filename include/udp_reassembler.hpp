@@ -0,0 +1,87 @@
+#ifndef UDP_REASSEMBLER_HPP
+#define UDP_REASSEMBLER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "udp_fragment.hpp"
+
+// Messages that can be in flight at once, older ones are given up on
+#define UDP_REASSEMBLER_NUM_SLOTS 8
+
+// Recent messages remembered as completed or given up on, one bit each
+#define UDP_REASSEMBLER_WINDOW 32
+
+// Further back than this is no late fragment, the sender started counting again
+#define UDP_REASSEMBLER_RESTART_JUMP (4 * UDP_REASSEMBLER_WINDOW)
+
+typedef struct
+{
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t messages;             // Complete ones
+    uint64_t lost_messages;        // Not a single fragment arrived before it left the window
+    uint64_t incomplete_messages;  // Given up on with fragments missing
+    uint64_t duplicate_fragments;
+    uint64_t late_fragments;       // Of a message that was already given up on
+    uint64_t invalid_datagrams;
+    uint64_t restarts;             // Of the sender, seen as its message number jumping back
+} udp_reassembler_stats_t;
+
+/*
+ * Receiver side of udp_streamer. Fragments of up to UDP_REASSEMBLER_NUM_SLOTS messages can be put
+ * together at the same time, and a message within UDP_REASSEMBLER_WINDOW of the newest is taken
+ * whenever its first fragment comes. Slot buffers are kept, a steady stream doesn't allocate.
+ */
+class udp_reassembler
+{
+    public:
+        udp_reassembler();
+        virtual ~udp_reassembler();
+
+        // True when the datagram completed a message, which is then available until the next add
+        bool add(const uint8_t* datagram, size_t length);
+
+        const uint8_t* get_message();
+        size_t get_message_length();
+        uint32_t get_message_sequence();
+
+        udp_reassembler_stats_t get_stats();
+
+    protected:
+
+    private:
+        typedef struct
+        {
+            bool used;
+            uint32_t message;
+            uint32_t length;
+            uint16_t num_fragments;
+            uint16_t received;
+            std::vector<uint8_t> data;
+            std::vector<bool> have;
+        } slot_t;
+
+        slot_t m_slots[UDP_REASSEMBLER_NUM_SLOTS];
+
+        // Newest message a fragment was seen of, bit i of m_done is m_newest - i
+        bool m_started = false;
+        uint32_t m_newest = 0;
+        uint32_t m_done = 0;
+
+        slot_t* m_complete = nullptr;
+
+        udp_reassembler_stats_t m_stats;
+
+        slot_t* find_slot(uint32_t message);
+        slot_t* claim_slot();
+        void release(slot_t* slot);
+
+        void advance(uint32_t message);
+        void mark_done(uint32_t message);
+        bool is_done(uint32_t message);
+};
+
+#endif //UDP_REASSEMBLER_HPP
@@ -0,0 +1,63 @@
+#ifndef UDP_STREAMER_HPP
+#define UDP_STREAMER_HPP
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "packet_sink.hpp"
+#include "udp_fragment.hpp"
+
+// Listeners may join at any time, so the config goes out again this often
+#define UDP_STREAMER_CONFIG_INTERVAL_MS 1000
+
+/*
+ * Sends every message as MTU sized datagrams to a unicast address or a multicast group, see
+ * udp_fragment.hpp. The cost is the same for any number of listeners. Datagrams are sent straight
+ * from the message buffers with a non-blocking gather send, whatever the socket buffer can't take
+ * is dropped. UDP makes no difference between droppable messages and the rest, anything can get
+ * lost on the way, which is why the config is repeated.
+ */
+class udp_streamer : public packet_sink
+{
+    public:
+        udp_streamer(uint32_t mtu, uint8_t multicast_ttl);
+        virtual ~udp_streamer();
+
+        bool open(const std::string& address, uint16_t port, std::string* error);
+
+        bool is_multicast();
+
+        void send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable);
+
+        // A UDP socket doesn't fail once it is open, lost datagrams show up as dropped
+        bool failed();
+        std::string get_error();
+
+        packet_sink_stats_t get_stats();
+
+    protected:
+
+    private:
+        uint32_t m_payload_size;
+        uint8_t m_multicast_ttl;
+
+        boost::asio::io_service m_io_service;
+        boost::asio::ip::udp::socket m_socket;
+        boost::asio::ip::udp::endpoint m_endpoint;
+
+        uint32_t m_message = 0;
+
+        // Header and payload pieces of the datagram being sent, reused
+        udp_fragment_header_t m_header;
+        std::vector<boost::asio::const_buffer> m_datagram;
+
+        uint64_t m_sent_bytes = 0;
+        uint64_t m_dropped_bytes = 0;
+        uint64_t m_dropped_messages = 0;
+};
+
+#endif //UDP_STREAMER_HPP
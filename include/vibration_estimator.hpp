@@ -0,0 +1,57 @@
+#ifndef VIBRATION_ESTIMATOR_HPP
+#define VIBRATION_ESTIMATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// What radar_config starts out with, for recordings that don't say
+#define VIBRATION_DEFAULT_CENTER_FREQUENCY_KHZ 60500000
+
+// Slower than this is drift, not vibration
+#define VIBRATION_MIN_FREQUENCY_HZ 0.1f
+
+// Longer series are cut to their most recent part, the transform is a plain DFT
+#define VIBRATION_MAX_POINTS 4096
+
+// Fewer points don't make a spectrum worth the name
+#define VIBRATION_MIN_POINTS 16
+
+typedef struct
+{
+    uint32_t bin_index;         // Into the bins given, the one that moves the most
+    float amplitude_m;          // Of the strongest sinusoid in the displacement
+    float frequency_hz;
+    float snr_db;               // Peak over the median of the spectrum
+} vibration_t;
+
+/*
+ * Estimates the vibration of a reflector from the slow-time series of the range bins around it.
+ * The bin with the most energy around its mean is taken, a circle is fitted to its samples and the
+ * phase around the centre unwrapped into displacement, and the strongest line of the Hann windowed
+ * displacement spectrum gives amplitude and frequency.
+ */
+class vibration_estimator
+{
+    public:
+        vibration_estimator(uint32_t center_frequency_khz = VIBRATION_DEFAULT_CENTER_FREQUENCY_KHZ);
+        virtual ~vibration_estimator();
+
+        // Bin b has num_points samples from real[b * bin_stride] / imag[b * bin_stride] on
+        bool estimate(const float* real, const float* imag, size_t bin_stride, uint32_t num_bins,
+                      uint32_t num_points, float frame_rate, vibration_t* result);
+
+    protected:
+
+    private:
+        double m_wavelength_m;
+
+        std::vector<double> m_displacement;
+        std::vector<double> m_power;
+
+        // Centre of the circle the samples of a reflector at a changing distance lie on
+        void fit_centre(const float* real, const float* imag, uint32_t num_points, double* centre_real, double* centre_imag);
+};
+
+#endif //VIBRATION_ESTIMATOR_HPP
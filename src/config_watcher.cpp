@@ -0,0 +1,141 @@
+#include "config_watcher.hpp"
+
+#include <iostream>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+config_watcher::config_watcher(const std::string& path, radar_config* current) : m_path(path),
+                                                                               m_base(*current),
+                                                                               m_pending(nullptr),
+                                                                               m_running(true)
+{
+    m_thread = std::thread(&config_watcher::watch_loop, this);
+}
+
+config_watcher::~config_watcher()
+{
+    m_running = false;
+    m_thread.join();
+
+    delete m_pending.exchange(nullptr);
+}
+
+radar_config* config_watcher::take_pending()
+{
+    return m_pending.exchange(nullptr);
+}
+
+void config_watcher::reload()
+{
+    radar_config candidate(m_base);
+    std::string error;
+
+    if (!candidate.load_file(m_path, &error))
+    {
+        std::cerr << "Ignoring config change: " << error << std::endl;
+        return;
+    }
+
+    m_base = candidate;
+
+    // A config nobody picked up yet is simply replaced by the newer one
+    delete m_pending.exchange(new radar_config(candidate));
+
+    std::cout << "Loaded new config from " << m_path << std::endl;
+}
+
+#ifdef __linux__
+
+void config_watcher::watch_loop()
+{
+    // Editors tend to replace the file rather than write it, so the directory is watched
+    std::string directory = ".";
+    std::string file_name = m_path;
+
+    size_t slash = m_path.find_last_of('/');
+    if (slash != std::string::npos)
+    {
+        directory = m_path.substr(0, slash);
+        file_name = m_path.substr(slash + 1);
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK);
+
+    if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cerr << "Can't watch " << m_path << ", config changes need a restart" << std::endl;
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return;
+    }
+
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    while (m_running)
+    {
+        struct pollfd poll_fd = {fd, POLLIN, 0};
+
+        if (poll(&poll_fd, 1, CONFIG_WATCHER_POLL_MS) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+
+        bool changed = false;
+
+        for (char* p = buffer; length > 0 && p < buffer + length; )
+        {
+            const struct inotify_event* event = (const struct inotify_event*) p;
+
+            if (event->len > 0 && file_name == event->name)
+            {
+                changed = true;
+            }
+
+            p += sizeof(struct inotify_event) + event->len;
+        }
+
+        if (changed)
+        {
+            this->reload();
+        }
+    }
+
+    close(fd);
+}
+
+#else
+
+void config_watcher::watch_loop()
+{
+    struct stat info;
+    time_t last_modified = 0;
+
+    if (stat(m_path.c_str(), &info) == 0)
+    {
+        last_modified = info.st_mtime;
+    }
+
+    while (m_running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_WATCHER_POLL_MS));
+
+        if (stat(m_path.c_str(), &info) == 0 && info.st_mtime != last_modified)
+        {
+            last_modified = info.st_mtime;
+            this->reload();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include "connection.hpp"
+
+#include "ifxRadarSDK.h"
+
+connection::connection(packet_sink* sink, encoding_t encoding, uint32_t topics, uint32_t divisor) : m_sink(sink),
+                                                                                                    m_encoding(encoding),
+                                                                                                    m_topics(topics),
+                                                                                                    m_divisor(divisor > 0 ? divisor : 1)
+{
+
+}
+
+connection::~connection()
+{
+    delete m_codec;
+    delete m_sink;
+}
+
+void connection::set_compression(compression_t compression, float max_error_db, float dynamic_range_db)
+{
+    delete m_codec;
+    m_codec = nullptr;
+
+    if (compression != COMPRESSION_NONE && m_encoding == ENCODING_BINARY)
+    {
+        m_codec = new payload_codec(compression, max_error_db, dynamic_range_db);
+    }
+}
+
+void connection::set_config_interval(uint32_t interval_ms)
+{
+    m_config_interval_us = interval_ms * 1000;
+}
+
+void connection::set_document(const uint8_t* data, size_t length, std::vector<boost::asio::const_buffer>* buffers)
+{
+    m_length = (uint32_t) length;
+
+    buffers->resize(2);
+    (*buffers)[0] = boost::asio::buffer(&m_length, 4);
+    (*buffers)[1] = boost::asio::buffer(data, length);
+}
+
+void connection::send_config(radar_config* rc)
+{
+    json config;
+    config["packet_type"] = "configuration";
+    config["sdk_version"] = ifx_radar_sdk_get_version_string();
+    config["encoding"] = get_encoding_name(m_encoding);
+    config["config"] = rc->create_json();
+
+    m_last_config_us = packet_time_us();
+
+    std::vector<boost::asio::const_buffer> buffers;
+
+    // Always text, so the receiver learns the encoding before it has to decode anything
+    if (m_encoding != ENCODING_BINARY)
+    {
+        encode_document(config, ENCODING_JSON, &m_encoded);
+        this->set_document(m_encoded.data(), m_encoded.size(), &buffers);
+    }
+    else
+    {
+        config["protocol_version"] = PACKET_VERSION;
+
+        // The error bounds the compressed payloads keep to
+        if (m_codec != nullptr)
+        {
+            config["compression"] = m_codec->create_json();
+        }
+
+        m_writer.begin(0, m_last_config_us);
+        m_writer.add_json(PACKET_TYPE_CONFIG, config.dump());
+        m_writer.end();
+
+        buffers = m_writer.get_buffers();
+    }
+
+    m_sink->send_config(buffers);
+
+    // Whatever the last frame pointed at was just overwritten
+    m_frame.clear();
+}
+
+bool connection::config_due()
+{
+    return m_config_interval_us > 0 && packet_time_us() - m_last_config_us >= m_config_interval_us;
+}
+
+bool connection::wants_frame(uint32_t sequence)
+{
+    return sequence % m_divisor == 0;
+}
+
+void connection::encode_frame(dsp* dsp_chain, uint32_t sequence, uint64_t timestamp_us)
+{
+    switch (m_encoding)
+    {
+        case ENCODING_BINARY:
+            m_writer.begin(sequence, timestamp_us, dsp_chain->get_done_time_us());
+            dsp_chain->write_packets(&m_writer, m_topics, m_codec);
+            m_writer.end();
+
+            m_frame = m_writer.get_buffers();
+            break;
+        case ENCODING_JSON:
+            // The document as create_json would give it, streamed out without building it
+            m_text.clear();
+            m_text.begin_object();
+            m_text.key("data");
+            dsp_chain->write_json(&m_text, m_topics);
+            m_text.key("packet_type");
+            m_text.value("data");
+            m_text.key("sequence");
+            m_text.value(sequence);
+            m_text.key("timing");
+            m_text.begin_object();
+            m_text.key("acquired_us");
+            m_text.value(timestamp_us);
+            m_text.key("dsp_done_us");
+            m_text.value(dsp_chain->get_done_time_us());
+            m_text.key("sent_us");
+            m_text.value(packet_time_us());
+            m_text.end_object();
+            m_text.end_object();
+
+            this->set_document((const uint8_t*) m_text.get_data(), m_text.get_size(), &m_frame);
+            break;
+        default:
+        {
+            json data;
+            data["packet_type"] = "data";
+            data["data"] = dsp_chain->create_json(m_topics);
+            data["sequence"] = sequence;
+            data["timing"]["acquired_us"] = timestamp_us;
+            data["timing"]["dsp_done_us"] = dsp_chain->get_done_time_us();
+            data["timing"]["sent_us"] = packet_time_us();
+
+            encode_document(data, m_encoding, &m_encoded);
+            this->set_document(m_encoded.data(), m_encoded.size(), &m_frame);
+            break;
+        }
+    }
+}
+
+void connection::send_frame(dsp* dsp_chain, uint32_t sequence, uint64_t timestamp_us, bool droppable, connection* shared)
+{
+    ++m_messages;
+
+    if (shared != nullptr && !shared->m_frame.empty())
+    {
+        // The sink copies before send returns, so the bytes can be restamped for every connection
+        if (m_encoding == ENCODING_BINARY)
+        {
+            shared->m_writer.stamp(m_messages, packet_time_us());
+        }
+
+        m_sink->send(shared->m_frame, droppable);
+        return;
+    }
+
+    this->encode_frame(dsp_chain, sequence, timestamp_us);
+
+    if (m_encoding == ENCODING_BINARY)
+    {
+        m_writer.stamp(m_messages, packet_time_us());
+    }
+
+    m_sink->send(m_frame, droppable);
+}
+
+bool connection::same_output(connection* other)
+{
+    return m_encoding == other->m_encoding && m_topics == other->m_topics && this->get_compression() == other->get_compression();
+}
+
+packet_sink* connection::get_sink()
+{
+    return m_sink;
+}
+
+encoding_t connection::get_encoding()
+{
+    return m_encoding;
+}
+
+compression_t connection::get_compression()
+{
+    return m_codec != nullptr ? m_codec->get_compression() : COMPRESSION_NONE;
+}
+
+uint32_t connection::get_topics()
+{
+    return m_topics;
+}
+
+uint32_t connection::get_divisor()
+{
+    return m_divisor;
+}
@@ -4,82 +4,130 @@
 
 #include <math.h>
 
+#include <string.h>
+
+#include <algorithm>
+#include <map>
 #include <vector>
 
-dsp::dsp(radar_config* radar_config) : m_radar_config(radar_config), num_frames_per_fft(NUM_FFT_POINTS / radar_config->get_device_config()->num_chirps_per_frame)
+dsp::dsp(radar_config* radar_config, uint32_t num_threads, const std::vector<uint32_t>& cpus) : m_radar_config(radar_config), num_frames_per_fft(NUM_FFT_POINTS / radar_config->get_device_config()->num_chirps_per_frame)
 {
-    float temp_bin = (range_interest / m_radar_config->get_device_metrics()->m_value_per_bin);
+    m_num_antennas = 0;
+    for (uint8_t mask = m_radar_config->get_device_metrics()->m_rx_antenna_number; mask != 0; mask >>= 1)
+    {
+        m_num_antennas += mask & 1;
+    }
 
-    important_bin = (uint32_t) (temp_bin + 0.5f);
+    m_range_spectrum = new range_spectrum_t[m_num_antennas];
+    m_gated_ffts = new const ifx_Matrix_C_t*[m_num_antennas];
+    m_gated_spectra = new const ifx_Vector_R_t*[m_num_antennas];
 
-    ofstream metrics_file;
-    metrics_file.open ("metrics.txt");
+    m_kernel = create_dsp_kernel(m_radar_config->get_device_config()->num_samples_per_chirp,
+                                 m_radar_config->get_device_config()->num_chirps_per_frame,
+                                 m_num_antennas);
+    m_active_kernel = m_kernel;
 
-    metrics_file << "range_resolution: " << m_radar_config->get_device_metrics()->m_range_resolution << endl;
-    metrics_file << "range_interest: " << range_interest << endl;
-    metrics_file << "bin_interest: " << important_bin << endl;
+    m_thread_pool = new thread_pool(num_threads, cpus);
 
-    for (int i = 0; i < NUM_FFT_POINTS; ++i)
-    {
-        metrics_file <<  ((float)i) * (1/ ((float)m_radar_config->get_device_metrics()->m_frame_rate)) ;
-        if (i < NUM_FFT_POINTS - 1)
-        {
-            metrics_file << ", ";
-        }
-    }
-    metrics_file << endl;
+    m_profile = m_radar_config->create_processing_profile();
 
-    metrics_file.close();
+    m_gate_start = m_profile->get_gate_start();
+    m_gate_num_bins = m_profile->get_gate_num_bins();
 
-    int range = 4;
+    important_bin = m_profile->get_bin_of_interest();
 
-    if (((int)important_bin) - range < 0)
-    {
-        min_bin = 0;
-    } else {
-        min_bin = important_bin - ((uint32_t)range);
-    }
-    max_bin = important_bin + range;
+    // Bins outside the range gate are never computed
+    min_bin = m_profile->get_slow_time_min_bin();
+    max_bin = m_profile->get_slow_time_max_bin();
     delta_bin = max_bin - min_bin + 1;
 
     mti_buffer_length = m_radar_config->get_device_metrics()->m_frame_rate * 4;
 
-    m_mti_test_handle = new mti(m_radar_config, mti_buffer_length, min_bin, max_bin);
-    fft_handle = new fft_circular[delta_bin];
-
-    data_file.open ("data.txt");
+    m_mti_test_handle = new mti(m_radar_config, mti_buffer_length, min_bin - m_gate_start, max_bin - m_gate_start);
+    // FFTW planning is not thread safe, the profile made the only plan before any worker runs
+    fft_handle = new fft_circular*[delta_bin];
+    for (uint32_t i = 0; i < delta_bin; ++i)
+    {
+        fft_handle[i] = new fft_circular(m_profile->get_slow_time_plan());
+    }
 
     this->create_spectrum_handle();
     this->create_mti_handle();
     this->create_doppler_fft_handle();
+    this->create_peak_search_handle();
+
+    m_tracker = new tracker(m_radar_config);
+    m_presence = new presence(m_radar_config, m_profile);
+    m_spectrogram = new spectrogram(m_radar_config, m_profile->get_num_doppler_bins());
+    m_azimuth_map = new range_angle(m_radar_config, m_profile);
+    m_elevation_map = new range_angle(m_radar_config, m_profile);
 }
 
 dsp::~dsp()
 {
+    delete m_thread_pool;
+    delete m_tracker;
+    delete m_presence;
+    delete m_spectrogram;
+    delete m_azimuth_map;
+    delete m_elevation_map;
     delete m_mti_test_handle;
+    for (uint32_t i = 0; i < delta_bin; ++i)
+    {
+        delete fft_handle[i];
+    }
     delete[] fft_handle;
     this->destroy_spectrum_handle();
     this->destroy_mti_handle();
     this->destroy_doppler_fft_handle();
+    this->destroy_peak_search_handle();
+
+    delete[] m_range_spectrum;
+    delete[] m_gated_ffts;
+    delete[] m_gated_spectra;
 
-    data_file.close();
+    delete m_kernel;
+    delete m_partial_kernel;
 }
 
 void dsp::create_spectrum_handle()
 {
-    ifx_Error_t err = ifx_range_spectrum_create(m_radar_config->get_range_spectrum_config(), &(this->m_range_spectrum.range_spectrum_handle));
+    for (uint32_t antenna = 0; antenna < m_num_antennas; ++antenna)
+    {
+        range_spectrum_t* range_spectrum = &(this->m_range_spectrum[antenna]);
 
-    err = ifx_range_spectrum_set_mode(this->m_range_spectrum.range_spectrum_handle, this->m_radar_config->get_device_metrics()->m_range_spectrum_mode);
+        ifx_Error_t err = ifx_range_spectrum_create(m_radar_config->get_range_spectrum_config(), &(range_spectrum->range_spectrum_handle));
 
+        err = ifx_range_spectrum_set_mode(range_spectrum->range_spectrum_handle, this->m_radar_config->get_device_metrics()->m_range_spectrum_mode);
 
-    if (ifx_vector_create_r((uint32_t) m_radar_config->get_device_metrics()->m_range_fft_size, &(this->m_range_spectrum.fft_spectrum_result)))
-    {
-        // TODO error check
+
+        if (ifx_vector_create_r((uint32_t) m_radar_config->get_device_metrics()->m_range_fft_size, &(range_spectrum->fft_spectrum_result)))
+        {
+            // TODO error check
+        }
+
+        if (ifx_matrix_create_c(m_radar_config->get_device_config()->num_chirps_per_frame,
+                                m_radar_config->get_device_metrics()->m_range_fft_size / 2,
+                                &(range_spectrum->frame_fft_half_result)))
+        {
+
+        }
+
+        if (ifx_vector_create_r(m_gate_num_bins, &(range_spectrum->gated_spectrum)))
+        {
+
+        }
+
+        if (ifx_matrix_create_c(m_radar_config->get_device_config()->num_chirps_per_frame, m_gate_num_bins, &(range_spectrum->gated_fft)))
+        {
+
+        }
+
+        m_gated_ffts[antenna] = &(range_spectrum->gated_fft);
+        m_gated_spectra[antenna] = &(range_spectrum->gated_spectrum);
     }
 
-    if (ifx_matrix_create_c(m_radar_config->get_device_config()->num_chirps_per_frame,
-                            m_radar_config->get_device_metrics()->m_range_fft_size / 2,
-                            &(this->m_range_spectrum.frame_fft_half_result)))
+    if (ifx_matrix_create_c(1, m_gate_num_bins, &(this->m_antenna_sum)))
     {
 
     }
@@ -87,29 +135,44 @@ void dsp::create_spectrum_handle()
 
 void dsp::destroy_spectrum_handle()
 {
-    if (ifx_range_spectrum_destroy(this->m_range_spectrum.range_spectrum_handle))
+    for (uint32_t antenna = 0; antenna < m_num_antennas; ++antenna)
     {
-        // TODO error check
-    }
+        range_spectrum_t* range_spectrum = &(this->m_range_spectrum[antenna]);
 
-    if (ifx_vector_destroy_r(&(this->m_range_spectrum.fft_spectrum_result)))
-    {
+        if (ifx_range_spectrum_destroy(range_spectrum->range_spectrum_handle))
+        {
+            // TODO error check
+        }
 
+        if (ifx_vector_destroy_r(&(range_spectrum->fft_spectrum_result)))
+        {
+
+        }
+
+        if (ifx_matrix_destroy_c(&(range_spectrum->frame_fft_half_result)))
+        {
+
+        }
+
+        ifx_vector_destroy_r(&(range_spectrum->gated_spectrum));
+        ifx_matrix_destroy_c(&(range_spectrum->gated_fft));
     }
 
-    if (ifx_matrix_destroy_c(&(this->m_range_spectrum.frame_fft_half_result)))
+    if (ifx_matrix_destroy_c(&(this->m_antenna_sum)))
     {
 
     }
 }
 
 void dsp::create_mti_handle() {
-    if (ifx_mti_create(m_radar_config->get_device_metrics()->m_mti_weight,
-                       m_radar_config->get_device_metrics()->m_range_fft_size / 2, &(this->m_mti.mti_handle))) {
-        // TODO Error check
+    ifx_Error_t err = ifx_mti_create(m_radar_config->get_device_metrics()->m_mti_weight,
+                                     m_gate_num_bins, &(this->m_mti.mti_handle));
+    if (err != IFX_OK) {
+        m_error = "can't create the detection MTI, SDK error " + std::to_string(err);
+        this->m_mti.mti_handle = nullptr;
     }
 
-    if (ifx_vector_create_r(m_radar_config->get_device_metrics()->m_range_fft_size / 2, &(this->m_mti.mti_result))) {
+    if (ifx_vector_create_r(m_gate_num_bins, &(this->m_mti.mti_result))) {
 
 
     }
@@ -117,7 +180,7 @@ void dsp::create_mti_handle() {
 
 void dsp::destroy_mti_handle()
 {
-    if (ifx_mti_destroy(this->m_mti.mti_handle))
+    if (this->m_mti.mti_handle != nullptr && ifx_mti_destroy(this->m_mti.mti_handle))
     {
 
     }
@@ -144,51 +207,653 @@ void dsp::destroy_doppler_fft_handle()
     ifx_fft_destroy(this->m_doppler_fft.doppler_fft_handle);
 }
 
+void dsp::create_peak_search_handle()
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    // Searches the whole gated spectrum
+    ifx_Peak_Search_Config_t config =
+    {
+        .value_per_bin = metrics->m_value_per_bin,
+        .search_zone_start = 0,
+        .search_zone_end = (m_gate_num_bins - 1) * metrics->m_value_per_bin,
+        .threshold_factor = metrics->m_threshold_factor_presence_peak,
+        .threshold_offset = 0,
+        .max_num_peaks = TRACKER_MAX_DETECTIONS
+    };
+
+    ifx_Error_t err = ifx_peak_search_create(&config, &(this->m_peak_search.peak_search_handle));
+    if (err != IFX_OK)
+    {
+        m_error = "can't create the detection peak search, SDK error " + std::to_string(err);
+        this->m_peak_search.peak_search_handle = nullptr;
+    }
+
+    this->m_peak_search.peak_search_result.peak_count = 0;
+    this->m_peak_search.peak_search_result.index = new uint32_t[TRACKER_MAX_DETECTIONS];
+}
+
+void dsp::destroy_peak_search_handle()
+{
+    if (this->m_peak_search.peak_search_handle != nullptr && ifx_peak_search_destroy(this->m_peak_search.peak_search_handle))
+    {
+
+    }
+
+    delete[] this->m_peak_search.peak_search_result.index;
+}
+
+bool dsp::range_transform(ifx_Frame_t* frame, uint32_t antenna)
+{
+    range_spectrum_t* range_spectrum = &(this->m_range_spectrum[antenna]);
+
+    range_spectrum->valid = false;
+
+    if (ifx_range_spectrum_run_r(range_spectrum->range_spectrum_handle, &(frame->rx_data[antenna]), &(range_spectrum->fft_spectrum_result)) ||
+        ifx_range_spectrum_get_fft_transformed_matrix(range_spectrum->range_spectrum_handle, &(range_spectrum->frame_fft_half_result)))
+    {
+        return false;
+    }
+
+    // Compact down to the detection zone
+    memcpy(range_spectrum->gated_spectrum.data,
+           range_spectrum->fft_spectrum_result.data + m_gate_start,
+           m_gate_num_bins * sizeof(ifx_Float_t));
+
+    m_active_kernel->gate(&(range_spectrum->frame_fft_half_result), m_gate_start, &(range_spectrum->gated_fft));
+
+    range_spectrum->valid = true;
+
+    return true;
+}
+
+void dsp::slow_time_update(uint32_t bin_index)
+{
+    // Index into the gated transforms
+    uint32_t bin = min_bin - m_gate_start + bin_index;
+
+    ifx_Complex_t sum = m_active_kernel->antenna_sum(m_gated_ffts, bin);
+    ifx_matrix_set_element_c(&(this->m_antenna_sum), 0, bin, sum);
+
+    m_mti_test_handle->train_average_bin(&(this->m_antenna_sum), bin);
+
+    ifx_Complex_t element;
+    ifx_matrix_get_element_c(&(this->m_antenna_sum), 0, bin, &element);
+
+    fft_handle[bin_index]->sample(element);
+}
+
+bool dsp::doppler_transform(uint32_t bin)
+{
+    m_active_kernel->doppler_input(&(this->m_range_spectrum[0].gated_fft), bin, m_profile->get_doppler_window(), this->m_doppler_fft.doppler_data.data);
+
+    if (ifx_fft_run_c(this->m_doppler_fft.doppler_fft_handle, &(this->m_doppler_fft.doppler_data), &(this->m_doppler_fft.chirp_fft_result)))
+    {
+        return false;
+    }
+
+    this->fft_shift(&(this->m_doppler_fft.chirp_fft_result));
+
+    return true;
+}
+
+bool dsp::estimate_speed(uint32_t bin, float* speed)
+{
+    if (!this->doppler_transform(bin))
+    {
+        return false;
+    }
+
+    *speed = m_profile->get_speed(m_active_kernel->doppler_peak(this->m_doppler_fft.chirp_fft_result.data));
+
+    return true;
+}
+
+float dsp::estimate_angle(uint32_t num_antennas, uint32_t bin)
+{
+    if (num_antennas <= DSP_AZIMUTH_ANTENNA_B)
+    {
+        return 0.0f;
+    }
+
+    ifx_Complex_t a;
+    ifx_Complex_t b;
+    ifx_matrix_get_element_c(&(this->m_range_spectrum[DSP_AZIMUTH_ANTENNA_A].gated_fft), 0, bin, &a);
+    ifx_matrix_get_element_c(&(this->m_range_spectrum[DSP_AZIMUTH_ANTENNA_B].gated_fft), 0, bin, &b);
+
+    // Phase of a * conj(b), antennas are half a wavelength apart
+    float real = a.data[REAL] * b.data[REAL] + a.data[IMAG] * b.data[IMAG];
+    float imag = a.data[IMAG] * b.data[REAL] - a.data[REAL] * b.data[IMAG];
+
+    float sine = atan2f(imag, real) / (float) M_PI;
+    sine = std::max(-1.0f, std::min(1.0f, sine));
+
+    return asinf(sine);
+}
+
+bool dsp::detect_targets(uint32_t num_antennas)
+{
+    m_num_detections = 0;
+
+    if (num_antennas == 0 || this->m_mti.mti_handle == nullptr || this->m_peak_search.peak_search_handle == nullptr)
+    {
+        return false;
+    }
+
+    // Mean gated amplitude spectrum over the antennas
+    ifx_Vector_R_t* spectrum = &(this->m_mti.mti_result);
+    m_active_kernel->mean_spectrum(m_gated_spectra, spectrum);
+
+    if (ifx_mti_run(this->m_mti.mti_handle, spectrum) ||
+        ifx_peak_search_run(this->m_peak_search.peak_search_handle, spectrum, &(this->m_peak_search.peak_search_result)))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < this->m_peak_search.peak_search_result.peak_count && m_num_detections < TRACKER_MAX_DETECTIONS; ++i)
+    {
+        uint32_t bin = this->m_peak_search.peak_search_result.index[i];
+
+        detection_t* detection = &m_detections[m_num_detections++];
+        detection->range = m_profile->get_range(bin);
+        detection->angle = this->estimate_angle(num_antennas, bin);
+
+        if (!this->estimate_speed(bin, &(detection->speed)))
+        {
+            m_num_detections = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 json dsp::run(ifx_Frame_t frame)
 {
-    time_stamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    this->process(frame);
+
+    return this->create_json();
+}
+
+void dsp::process(ifx_Frame_t frame)
+{
+    std::chrono::steady_clock::time_point run_start = std::chrono::steady_clock::now();
+
     this->run_count += 1;
 
-    ifx_Matrix_R_t rx_data = frame.rx_data[0];
-    ifx_Matrix_R_t rx_data1 = frame.rx_data[1];
-    ifx_Matrix_R_t rx_data2 = frame.rx_data[2];
+    uint32_t num_antennas = std::min((uint32_t) frame.num_rx, m_num_antennas);
 
-    json data;
+    m_coarse_ran = false;
+    m_full_ran = false;
+    m_frame_valid = false;
+    m_tracks_valid = false;
+    m_tile_ready = false;
+    m_azimuth_valid = false;
+    m_elevation_valid = false;
+    m_slow_time_valid = false;
+
+    if (num_antennas == 0)
+    {
+        return;
+    }
+
+    m_active_kernel = m_kernel;
+
+    if (num_antennas != m_num_antennas)
+    {
+        if (m_partial_num_antennas != num_antennas)
+        {
+            delete m_partial_kernel;
+            m_partial_kernel = create_dsp_kernel(m_radar_config->get_device_config()->num_samples_per_chirp,
+                                                 m_radar_config->get_device_config()->num_chirps_per_frame,
+                                                 num_antennas);
+            m_partial_num_antennas = num_antennas;
+        }
+
+        m_active_kernel = m_partial_kernel;
+    }
+
+    // Coarse tier, a single antenna range spectrum is enough to decide on presence
+    if (!this->range_transform(&frame, 0))
+    {
+        // Nothing of this frame can be trusted, presence included
+        m_last_run_time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run_start).count();
+        m_done_time_us = packet_time_us();
+        return;
+    }
+
+    m_presence->update(&(this->m_range_spectrum[0].gated_spectrum));
+    m_coarse_ran = true;
+
+    if (m_presence->get_state() == PRESENCE_STATE_PRESENT)
+    {
+        this->run_full(&frame, num_antennas);
+    }
+    else if (m_presence->state_changed())
+    {
+        // Tracks would be stale by the time somebody shows up again
+        m_tracker->reset();
+        m_spectrogram->reset();
+    }
+
+    m_last_run_time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run_start).count();
+    m_done_time_us = packet_time_us();
+}
+
+void dsp::run_full(ifx_Frame_t* frame, uint32_t num_antennas)
+{
+    m_full_ran = true;
+
+    // Antenna zero was already transformed by the coarse tier
+    m_thread_pool->run_batch(num_antennas - 1, [this, frame](uint32_t antenna) { this->range_transform(frame, antenna + 1); });
+
+    // A failed antenna would feed stale spectra into every stage, the frame is skipped instead
+    for (uint32_t antenna = 1; antenna < num_antennas; ++antenna)
+    {
+        if (!this->m_range_spectrum[antenna].valid)
+        {
+            m_full_ran = false;
+            return;
+        }
+    }
+
+    if (m_stages & DSP_STAGE_SLOW_TIME)
+    {
+        m_thread_pool->run_batch(delta_bin, [this](uint32_t bin_index) { this->slow_time_update(bin_index); });
+
+        m_slow_time_valid = true;
+    }
+
+    bool azimuth_enabled = (m_stages & DSP_STAGE_AZIMUTH) && num_antennas > DSP_AZIMUTH_ANTENNA_B;
+    bool elevation_enabled = (m_stages & DSP_STAGE_ELEVATION) && num_antennas > DSP_ELEVATION_ANTENNA_B;
+    if (azimuth_enabled || elevation_enabled)
+    {
+        // Task zero does azimuth, task one elevation
+        m_thread_pool->run_batch(2, [this, azimuth_enabled, elevation_enabled](uint32_t pair)
+        {
+            if (pair == 0 && azimuth_enabled)
+            {
+                m_azimuth_map->run(&(this->m_range_spectrum[DSP_AZIMUTH_ANTENNA_A].gated_fft), &(this->m_range_spectrum[DSP_AZIMUTH_ANTENNA_B].gated_fft));
+            }
+            else if (pair == 1 && elevation_enabled)
+            {
+                m_elevation_map->run(&(this->m_range_spectrum[DSP_ELEVATION_ANTENNA_A].gated_fft), &(this->m_range_spectrum[DSP_ELEVATION_ANTENNA_B].gated_fft));
+            }
+        });
+    }
+
+    // A failed SDK run leaves the tracks as they were rather than coasting them on nothing
+    if ((m_stages & DSP_STAGE_TRACKS) && this->detect_targets(num_antennas))
+    {
+        m_tracker->update(m_detections, m_num_detections, 1.0f / m_radar_config->get_device_metrics()->m_frame_rate);
+
+        m_tracks_valid = true;
+    }
+
+    // Micro-Doppler of whatever the presence tier is locked on to
+    if ((m_stages & DSP_STAGE_SPECTROGRAM) && this->doppler_transform(m_presence->get_target_bin()))
+    {
+        m_spectrogram->add_column(&(this->m_doppler_fft.chirp_fft_result));
 
-    data["frame"] = std::vector<float>(rx_data.columns);
+        m_tile_ready = m_spectrogram->tile_ready();
+    }
 
+    m_azimuth_valid = azimuth_enabled;
+    m_elevation_valid = elevation_enabled;
 
-    for (int i = 0; i < rx_data.columns; ++i)
+    if (!(m_stages & DSP_STAGE_FRAME))
     {
-//        float element;
-//        float element1;
-//        float element2;
-//        ifx_matrix_get_element_r(&rx_data, 0, i, &element);
-//        ifx_matrix_get_element_r(&rx_data1, 0, i, &element1);
-//        ifx_matrix_get_element_r(&rx_data2, 0, i, &element2);
-//        data["frame"][i] = element + element1 + element2;
+        return;
+    }
 
+    // The frame belongs to the source, the first chirp is kept until the next frame
+    ifx_Matrix_R_t rx_data = frame->rx_data[0];
 
+    m_frame_row.resize(rx_data.columns);
+
+    for (uint32_t i = 0; i < rx_data.columns; ++i)
+    {
         float element;
         ifx_matrix_get_element_r(&rx_data, 0, i, &element);
 
-        data["frame"][i] = element;
+        m_frame_row[i] = element;
+    }
+
+    m_frame_valid = true;
+}
+
+json dsp::create_json(uint32_t topics)
+{
+    json data;
+
+    data["presence"] = m_presence->create_json();
+
+    if (!m_full_ran)
+    {
+        return data;
+    }
+
+    if (m_tracks_valid && (topics & DSP_STAGE_TRACKS))
+    {
+        data["tracks"] = m_tracker->create_json();
     }
 
+    if (m_tile_ready && (topics & DSP_STAGE_SPECTROGRAM))
+    {
+        data["spectrogram"] = m_spectrogram->create_json(DSP_SPECTROGRAM_QUANTISED);
+    }
+
+    if (m_azimuth_valid && (topics & DSP_STAGE_AZIMUTH))
+    {
+        data["range_angle"]["azimuth"] = m_azimuth_map->create_json();
+    }
+
+    if (m_elevation_valid && (topics & DSP_STAGE_ELEVATION))
+    {
+        data["range_angle"]["elevation"] = m_elevation_map->create_json();
+    }
+
+    if (m_frame_valid && (topics & DSP_STAGE_FRAME))
+    {
+        data["frame"] = m_frame_row;
+    }
 
     return data;
 }
 
-void dsp::print_complex(fftw_complex* signal, ofstream &location)
+void dsp::write_json(json_writer* writer, uint32_t topics)
 {
-    for (int i = 0; i < NUM_FFT_POINTS; ++i)
+    // Keys in the order a json object keeps them
+    writer->begin_object();
+
+    if (m_full_ran && m_frame_valid && (topics & DSP_STAGE_FRAME))
     {
-        float abs = sqrt(signal[i][REAL] * signal[i][REAL] + signal[i][IMAG] * signal[i][IMAG]);
-        location << std::setprecision(40) << abs << " ";
+        writer->key("frame");
+        writer->values(m_frame_row.data(), (uint32_t) m_frame_row.size());
     }
-    location << endl;
+
+    writer->key("presence");
+    m_presence->write_json(writer);
+
+    bool azimuth = m_azimuth_valid && (topics & DSP_STAGE_AZIMUTH);
+    bool elevation = m_elevation_valid && (topics & DSP_STAGE_ELEVATION);
+
+    if (m_full_ran && (azimuth || elevation))
+    {
+        writer->key("range_angle");
+        writer->begin_object();
+
+        if (azimuth)
+        {
+            writer->key("azimuth");
+            m_azimuth_map->write_json(writer);
+        }
+
+        if (elevation)
+        {
+            writer->key("elevation");
+            m_elevation_map->write_json(writer);
+        }
+
+        writer->end_object();
+    }
+
+    if (m_full_ran && m_tile_ready && (topics & DSP_STAGE_SPECTROGRAM))
+    {
+        writer->key("spectrogram");
+        m_spectrogram->write_json(writer, DSP_SPECTROGRAM_QUANTISED);
+    }
+
+    if (m_full_ran && m_tracks_valid && (topics & DSP_STAGE_TRACKS))
+    {
+        writer->key("tracks");
+        m_tracker->write_json(writer);
+    }
+
+    writer->end_object();
+}
+
+void dsp::write_packets(packet_writer* writer, uint32_t topics, payload_codec* codec)
+{
+    float presence[2] = {m_presence->get_state() == PRESENCE_STATE_PRESENT ? 1.0f : 0.0f, m_presence->get_target_range()};
+    uint32_t presence_dims[1] = {2};
+    writer->add(PACKET_TYPE_PRESENCE, PACKET_DTYPE_F32, presence_dims, 1, presence, sizeof(presence));
+
+    if (!m_full_ran)
+    {
+        return;
+    }
+
+    if (m_tracks_valid && (topics & DSP_STAGE_TRACKS))
+    {
+        float tracks[TRACKER_MAX_TRACKS * 4];
+        uint32_t tracks_dims[2] = {m_tracker->get_confirmed(tracks, TRACKER_MAX_TRACKS), 4};
+        writer->add(PACKET_TYPE_TRACKS, PACKET_DTYPE_F32, tracks_dims, 2, tracks, tracks_dims[0] * 4 * sizeof(float));
+    }
+
+    if (m_tile_ready && (topics & DSP_STAGE_SPECTROGRAM))
+    {
+        uint32_t tile_dims[2] = {m_spectrogram->get_num_columns(), m_spectrogram->get_num_rows()};
+        uint32_t tile_size = tile_dims[0] * tile_dims[1];
+
+        // The tile is read out straight into the packet
+        if (codec != nullptr)
+        {
+            m_tile.resize(tile_size);
+            m_spectrogram->get_tile(m_tile.data());
+
+            const std::vector<uint8_t>& packed = codec->compress(m_tile.data(), tile_size, true);
+            writer->add(PACKET_TYPE_SPECTROGRAM, PACKET_DTYPE_COMPRESSED, tile_dims, 2, packed.data(), (uint32_t) packed.size());
+        }
+        else if (DSP_SPECTROGRAM_QUANTISED)
+        {
+            m_spectrogram->get_tile_quantised((uint8_t*) writer->add_uninitialised(PACKET_TYPE_SPECTROGRAM, PACKET_DTYPE_U8, tile_dims, 2, tile_size));
+        }
+        else
+        {
+            m_spectrogram->get_tile((float*) writer->add_uninitialised(PACKET_TYPE_SPECTROGRAM, PACKET_DTYPE_F32, tile_dims, 2, tile_size * sizeof(float)));
+        }
+    }
+
+    // The maps and the frame row stay untouched until the next process, they are sent from where they are
+    uint32_t map_dims[2] = {RANGE_ANGLE_NUM_BINS, m_gate_num_bins};
+
+    if (m_azimuth_valid && (topics & DSP_STAGE_AZIMUTH))
+    {
+        this->write_map(writer, PACKET_TYPE_RANGE_ANGLE_AZIMUTH, m_azimuth_map->get_map(), map_dims, codec);
+    }
+
+    if (m_elevation_valid && (topics & DSP_STAGE_ELEVATION))
+    {
+        this->write_map(writer, PACKET_TYPE_RANGE_ANGLE_ELEVATION, m_elevation_map->get_map(), map_dims, codec);
+    }
+
+    if (m_frame_valid && (topics & DSP_STAGE_FRAME))
+    {
+        uint32_t frame_dims[1] = {(uint32_t) m_frame_row.size()};
+        writer->add_reference(PACKET_TYPE_FRAME, PACKET_DTYPE_F32, frame_dims, 1, m_frame_row.data(), frame_dims[0] * sizeof(float));
+    }
+}
+
+void dsp::write_map(packet_writer* writer, packet_type_t type, const float* map, const uint32_t* map_dims, payload_codec* codec)
+{
+    uint32_t map_size = map_dims[0] * map_dims[1];
+
+    if (codec == nullptr)
+    {
+        writer->add_reference(type, PACKET_DTYPE_F32, map_dims, 2, map, map_size * sizeof(float));
+        return;
+    }
+
+    // The codec reuses its output, so the packed map is copied into the packet
+    const std::vector<uint8_t>& packed = codec->compress(map, map_size, false);
+    writer->add(type, PACKET_DTYPE_COMPRESSED, map_dims, 2, packed.data(), (uint32_t) packed.size());
 }
 
+void dsp::write_slow_time_schema(slow_time_recorder* recorder)
+{
+    json metrics;
+    metrics["range_resolution"] = m_radar_config->get_device_metrics()->m_range_resolution;
+    metrics["range_interest"] = PROCESSING_PROFILE_RANGE_OF_INTEREST_M;
+    metrics["bin_interest"] = important_bin;
+    metrics["frame_rate"] = m_radar_config->get_device_metrics()->m_frame_rate;
+    metrics["center_frequency_khz"] = m_radar_config->get_device_metrics()->m_fmcw_center_frequency_khz;
+
+    recorder->begin(metrics, min_bin, delta_bin, NUM_FFT_POINTS);
+
+    m_slow_time_real.resize(delta_bin);
+    m_slow_time_imag.resize(delta_bin);
+}
+
+void dsp::write_slow_time(slow_time_recorder* recorder, uint32_t sequence, uint64_t timestamp_us)
+{
+    if (!m_slow_time_valid || recorder->get_num_bins() != delta_bin)
+    {
+        return;
+    }
+
+    for (uint32_t bin_index = 0; bin_index < delta_bin; ++bin_index)
+    {
+        ifx_Complex_t element;
+        ifx_matrix_get_element_c(&(this->m_antenna_sum), 0, min_bin - m_gate_start + bin_index, &element);
+
+        m_slow_time_real[bin_index] = element.data[REAL];
+        m_slow_time_imag[bin_index] = element.data[IMAG];
+    }
+
+    recorder->add_row(timestamp_us, sequence, m_slow_time_real.data(), m_slow_time_imag.data());
+
+    // Every bin is sampled on every frame, their transforms complete together
+    if (fft_handle[0]->get_result() == nullptr)
+    {
+        return;
+    }
+
+    m_slow_time_spectra.resize((size_t) delta_bin * NUM_FFT_POINTS);
+
+    for (uint32_t bin_index = 0; bin_index < delta_bin; ++bin_index)
+    {
+        fftw_complex* result = fft_handle[bin_index]->get_result();
+        float* magnitudes = &m_slow_time_spectra[(size_t) bin_index * NUM_FFT_POINTS];
+
+        for (uint32_t i = 0; i < NUM_FFT_POINTS; ++i)
+        {
+            magnitudes[i] = (float) sqrt(result[i][REAL] * result[i][REAL] + result[i][IMAG] * result[i][IMAG]);
+        }
+    }
+
+    recorder->add_spectra(timestamp_us, sequence, m_slow_time_spectra.data());
+}
+
+bool dsp::failed()
+{
+    return !m_error.empty() || m_profile->failed() || m_presence->failed();
+}
+
+std::string dsp::get_error()
+{
+    if (!m_error.empty())
+    {
+        return m_error;
+    }
+
+    return m_profile->failed() ? m_profile->get_error() : m_presence->get_error();
+}
+
+bool dsp::is_presence_confirmed()
+{
+    return m_presence->get_state() == PRESENCE_STATE_PRESENT;
+}
+
+bool dsp::presence_changed()
+{
+    // A skipped frame must not repeat the transition of the one before
+    return m_coarse_ran && m_presence->state_changed();
+}
+
+bool dsp::motion_detected()
+{
+    return m_presence->get_state() == PRESENCE_STATE_PRESENT || m_presence->motion_detected();
+}
+
+uint64_t dsp::get_last_run_time_us()
+{
+    return m_last_run_time_us;
+}
+
+uint64_t dsp::get_done_time_us()
+{
+    return m_done_time_us;
+}
+
+uint32_t dsp::get_num_threads()
+{
+    return m_thread_pool->get_num_threads();
+}
+
+bool dsp::is_specialised()
+{
+    return m_kernel->is_specialised();
+}
+
+void dsp::update_config()
+{
+    for (uint32_t antenna = 0; antenna < m_num_antennas; ++antenna)
+    {
+        ifx_range_spectrum_set_mode(this->m_range_spectrum[antenna].range_spectrum_handle, this->m_radar_config->get_device_metrics()->m_range_spectrum_mode);
+    }
+
+    m_error.clear();
+
+    // The slow time MTI history spans a fixed time, a new frame rate changes its length in frames
+    uint32_t buffer_length = m_radar_config->get_device_metrics()->m_frame_rate * 4;
+    if (buffer_length != mti_buffer_length)
+    {
+        mti_buffer_length = buffer_length;
+
+        delete m_mti_test_handle;
+        m_mti_test_handle = new mti(m_radar_config, mti_buffer_length, min_bin - m_gate_start, max_bin - m_gate_start);
+    }
+
+    this->destroy_mti_handle();
+    this->create_mti_handle();
+
+    this->destroy_peak_search_handle();
+    this->create_peak_search_handle();
+
+    m_presence->update_config();
+    m_tracker->update_config();
+}
+
+void dsp::set_stages(uint32_t stages)
+{
+    m_stages = stages;
+}
+
+bool dsp::parse_stage(const std::string& name, uint32_t* stage)
+{
+    static const std::map<std::string, uint32_t> names =
+    {
+        {"frame", DSP_STAGE_FRAME},
+        {"slow_time", DSP_STAGE_SLOW_TIME},
+        {"tracks", DSP_STAGE_TRACKS},
+        {"spectrogram", DSP_STAGE_SPECTROGRAM},
+        {"azimuth", DSP_STAGE_AZIMUTH},
+        {"elevation", DSP_STAGE_ELEVATION}
+    };
+
+    std::map<std::string, uint32_t>::const_iterator found = names.find(name);
+
+    if (found == names.end())
+    {
+        return false;
+    }
+
+    *stage = found->second;
+    return true;
+}
+
+
 float dsp::create_scale(ifx_Vector_R_t* win)
 {
     ifx_Float_t fnorm = 0;
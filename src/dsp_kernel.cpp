@@ -0,0 +1,133 @@
+#include "dsp_kernel.hpp"
+
+#include <string.h>
+
+#define REAL 0
+#define IMAG 1
+
+/*
+ * One implementation for every build. A size given as template argument is a compile time
+ * constant, so loops over chirps and antennas get unrolled and vectorised. Zero means the size is
+ * only known at run time, which is the generic build.
+ */
+template <uint32_t NUM_SAMPLES, uint32_t NUM_CHIRPS, uint32_t NUM_ANTENNAS>
+class dsp_kernel_impl : public dsp_kernel
+{
+    public:
+        dsp_kernel_impl(uint32_t num_samples, uint32_t num_chirps, uint32_t num_antennas) : m_num_samples(num_samples),
+                                                                                             m_num_chirps(num_chirps),
+                                                                                             m_num_antennas(num_antennas)
+        {
+
+        }
+
+        void gate(const ifx_Matrix_C_t* full, uint32_t gate_start, ifx_Matrix_C_t* gated)
+        {
+            // The transform is range_fft_size / 2 wide, which needn't be half the samples
+            const uint32_t full_bins = full->columns;
+            const uint32_t num_bins = gated->columns;
+
+            for (uint32_t chirp = 0; chirp < this->num_chirps(); ++chirp)
+            {
+                memcpy(gated->data + chirp * num_bins,
+                       full->data + chirp * full_bins + gate_start,
+                       num_bins * sizeof(ifx_Complex_t));
+            }
+        }
+
+        void mean_spectrum(const ifx_Vector_R_t* const* spectra, ifx_Vector_R_t* mean)
+        {
+            const float scale = 1.0f / this->num_antennas();
+
+            for (uint32_t i = 0; i < mean->length; ++i)
+            {
+                float sum = 0.0f;
+                for (uint32_t antenna = 0; antenna < this->num_antennas(); ++antenna)
+                {
+                    sum += spectra[antenna]->data[i];
+                }
+                mean->data[i] = sum * scale;
+            }
+        }
+
+        ifx_Complex_t antenna_sum(const ifx_Matrix_C_t* const* ffts, uint32_t bin)
+        {
+            // Antennas are always summed in the same order so the result does not depend on scheduling
+            ifx_Complex_t sum = {0};
+            for (uint32_t antenna = 0; antenna < this->num_antennas(); ++antenna)
+            {
+                const ifx_Complex_t element = ffts[antenna]->data[bin];
+
+                sum.data[REAL] += element.data[REAL];
+                sum.data[IMAG] += element.data[IMAG];
+            }
+
+            return sum;
+        }
+
+        void doppler_input(const ifx_Matrix_C_t* fft, uint32_t bin, const float* window, ifx_Complex_t* out)
+        {
+            const uint32_t num_bins = fft->columns;
+            const ifx_Complex_t* column = fft->data + bin;
+
+            for (uint32_t chirp = 0; chirp < this->num_chirps(); ++chirp)
+            {
+                const ifx_Complex_t element = column[chirp * num_bins];
+
+                out[chirp].data[REAL] = element.data[REAL] * window[chirp];
+                out[chirp].data[IMAG] = element.data[IMAG] * window[chirp];
+            }
+        }
+
+        uint32_t doppler_peak(const ifx_Complex_t* spectrum)
+        {
+            uint32_t peak = 0;
+            float peak_power = -1.0f;
+
+            for (uint32_t i = 0; i < 2 * this->num_chirps(); ++i)
+            {
+                float power = spectrum[i].data[REAL] * spectrum[i].data[REAL] + spectrum[i].data[IMAG] * spectrum[i].data[IMAG];
+
+                if (power > peak_power)
+                {
+                    peak_power = power;
+                    peak = i;
+                }
+            }
+
+            return peak;
+        }
+
+        bool is_specialised()
+        {
+            return NUM_SAMPLES != 0;
+        }
+
+    private:
+        uint32_t m_num_samples;
+        uint32_t m_num_chirps;
+        uint32_t m_num_antennas;
+
+        uint32_t num_samples() const { return NUM_SAMPLES ? NUM_SAMPLES : m_num_samples; }
+        uint32_t num_chirps() const { return NUM_CHIRPS ? NUM_CHIRPS : m_num_chirps; }
+        uint32_t num_antennas() const { return NUM_ANTENNAS ? NUM_ANTENNAS : m_num_antennas; }
+};
+
+// Generic build plus one per fleet profile
+template class dsp_kernel_impl<0, 0, 0>;
+
+#define DSP_KERNEL_INSTANTIATE(samples, chirps, antennas) template class dsp_kernel_impl<samples, chirps, antennas>;
+DSP_KERNEL_PROFILES(DSP_KERNEL_INSTANTIATE)
+
+dsp_kernel* create_dsp_kernel(uint32_t num_samples, uint32_t num_chirps, uint32_t num_antennas)
+{
+#define DSP_KERNEL_DISPATCH(samples, chirps, antennas) \
+    if (num_samples == samples && num_chirps == chirps && num_antennas == antennas) \
+    { \
+        return new dsp_kernel_impl<samples, chirps, antennas>(num_samples, num_chirps, num_antennas); \
+    }
+
+    DSP_KERNEL_PROFILES(DSP_KERNEL_DISPATCH)
+
+    return new dsp_kernel_impl<0, 0, 0>(num_samples, num_chirps, num_antennas);
+}
@@ -0,0 +1,47 @@
+#include "encoding.hpp"
+
+static const char* encoding_names[] = {"binary", "json", "msgpack", "cbor", "ubjson"};
+
+bool parse_encoding(const std::string& name, encoding_t* encoding)
+{
+    for (uint32_t i = 0; i < sizeof(encoding_names) / sizeof(encoding_names[0]); ++i)
+    {
+        if (name == encoding_names[i])
+        {
+            *encoding = (encoding_t) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* get_encoding_name(encoding_t encoding)
+{
+    return encoding_names[encoding];
+}
+
+void encode_document(const json& document, encoding_t encoding, std::vector<uint8_t>* out)
+{
+    out->clear();
+
+    switch (encoding)
+    {
+        case ENCODING_MSGPACK:
+            json::to_msgpack(document, *out);
+            break;
+        case ENCODING_CBOR:
+            json::to_cbor(document, *out);
+            break;
+        case ENCODING_UBJSON:
+            // Typed float arrays are the point of ubjson, without them it's barely smaller than text
+            json::to_ubjson(document, *out, true, true);
+            break;
+        default:
+        {
+            std::string text = document.dump();
+            out->assign(text.begin(), text.end());
+            break;
+        }
+    }
+}
@@ -3,21 +3,14 @@
 #define REAL 0
 #define IMAG 1
 
-fft_circular::fft_circular()
+fft_circular::fft_circular(fftw_plan plan) : m_plan(plan)
 {
     signal = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * NUM_FFT_POINTS);
     result = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * NUM_FFT_POINTS);
-    plan = fftw_plan_dft_1d(NUM_FFT_POINTS,
-                                    signal,
-                                    result,
-                                    FFTW_FORWARD,
-                                    FFTW_ESTIMATE);
 }
 
 fft_circular::~fft_circular()
 {
-    fftw_destroy_plan(plan);
-
     fftw_free(signal);
     fftw_free(result);
 }
@@ -50,7 +43,8 @@ void fft_circular::sample(ifx_Complex_t element)
             signal[i][IMAG] -= avg_imag;
         }
 
-        fftw_execute(plan);
+        // One plan serves every instance, fftw_malloc gives the alignment it was made for
+        fftw_execute_dft(m_plan, signal, result);
 
         result_valid = true;
     }
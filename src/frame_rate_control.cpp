@@ -0,0 +1,58 @@
+#include "frame_rate_control.hpp"
+
+frame_rate_control::frame_rate_control(radar_config* radar_config) : m_radar_config(radar_config)
+{
+    m_nominal_frame_rate = m_radar_config->get_device_metrics()->m_frame_rate;
+    m_frame_rate = m_nominal_frame_rate;
+}
+
+frame_rate_control::~frame_rate_control()
+{
+    //dtor
+}
+
+bool frame_rate_control::update(bool motion)
+{
+    if (motion)
+    {
+        m_idle_frames = 0;
+
+        if (m_frame_rate != m_nominal_frame_rate)
+        {
+            m_frame_rate = m_nominal_frame_rate;
+            return true;
+        }
+
+        return false;
+    }
+
+    m_idle_frames += 1;
+
+    if (m_idle_frames < (uint32_t) (FRAME_RATE_IDLE_STEP_S * m_frame_rate) || m_frame_rate <= FRAME_RATE_IDLE_HZ)
+    {
+        return false;
+    }
+
+    m_idle_frames = 0;
+
+    m_frame_rate *= 0.5f;
+
+    if (m_frame_rate < FRAME_RATE_IDLE_HZ)
+    {
+        m_frame_rate = FRAME_RATE_IDLE_HZ;
+    }
+
+    return true;
+}
+
+void frame_rate_control::reset()
+{
+    m_nominal_frame_rate = m_radar_config->get_device_metrics()->m_frame_rate;
+    m_frame_rate = m_nominal_frame_rate;
+    m_idle_frames = 0;
+}
+
+float frame_rate_control::get_frame_rate()
+{
+    return m_frame_rate;
+}
@@ -0,0 +1,66 @@
+#include "frame_recorder.hpp"
+
+#include <string.h>
+
+frame_recorder::frame_recorder(radar_config* rc) : m_radar_config(rc)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+frame_recorder::~frame_recorder()
+{
+    m_file.close();
+}
+
+bool frame_recorder::open(const std::string& path, std::string* error)
+{
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!m_file.is_open())
+    {
+        *error = "can't create " + path;
+        return false;
+    }
+
+    ifx_Device_Config_t* config = m_radar_config->get_device_config();
+
+    memcpy(m_header.magic, FRAME_CAPTURE_MAGIC, sizeof(m_header.magic));
+    m_header.version = FRAME_CAPTURE_VERSION;
+    m_header.num_rx = 0;
+    for (uint8_t mask = config->rx_antenna_mask; mask != 0; mask >>= 1)
+    {
+        m_header.num_rx += mask & 1;
+    }
+    m_header.num_chirps = config->num_chirps_per_frame;
+    m_header.num_samples = config->num_samples_per_chirp;
+    m_header.frame_rate = m_radar_config->get_device_metrics()->m_frame_rate;
+
+    m_file.write((const char*) &m_header, sizeof(m_header));
+
+    return true;
+}
+
+void frame_recorder::write(ifx_Frame_t* frame)
+{
+    if (!m_file.is_open() || frame->num_rx != m_header.num_rx)
+    {
+        return;
+    }
+
+    for (uint32_t antenna = 0; antenna < frame->num_rx; ++antenna)
+    {
+        ifx_Matrix_R_t* rx_data = &(frame->rx_data[antenna]);
+
+        if (rx_data->rows != m_header.num_chirps || rx_data->columns != m_header.num_samples)
+        {
+            return;
+        }
+    }
+
+    for (uint32_t antenna = 0; antenna < frame->num_rx; ++antenna)
+    {
+        ifx_Matrix_R_t* rx_data = &(frame->rx_data[antenna]);
+
+        m_file.write((const char*) rx_data->data, rx_data->rows * rx_data->columns * sizeof(ifx_Float_t));
+    }
+}
@@ -0,0 +1,43 @@
+#include "frame_source.hpp"
+
+#include <thread>
+
+frame_source::frame_source() : m_next_frame(std::chrono::steady_clock::now())
+{
+
+}
+
+frame_source::~frame_source()
+{
+    //dtor
+}
+
+bool frame_source::finished()
+{
+    return false;
+}
+
+void frame_source::set_paced(bool paced)
+{
+    m_paced = paced;
+}
+
+void frame_source::wait_for_next_frame(float frame_rate)
+{
+    if (!m_paced || frame_rate <= 0.0f)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // After a stall the schedule restarts instead of bursting to catch up
+    if (m_next_frame < now)
+    {
+        m_next_frame = now;
+    }
+
+    std::this_thread::sleep_until(m_next_frame);
+
+    m_next_frame += std::chrono::microseconds((uint64_t) (1.0e6f / frame_rate));
+}
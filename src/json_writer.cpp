@@ -0,0 +1,235 @@
+#include "json_writer.hpp"
+
+#include <math.h>
+
+#include "json.hpp"
+
+json_writer::json_writer()
+{
+    m_has_items[0] = false;
+}
+
+json_writer::~json_writer()
+{
+    //dtor
+}
+
+void json_writer::clear()
+{
+    m_buffer.clear();
+    m_depth = 0;
+    m_has_items[0] = false;
+    m_after_key = false;
+}
+
+void json_writer::separate()
+{
+    if (m_after_key)
+    {
+        m_after_key = false;
+        return;
+    }
+
+    if (m_has_items[m_depth])
+    {
+        m_buffer.push_back(',');
+    }
+
+    m_has_items[m_depth] = true;
+}
+
+void json_writer::begin_object()
+{
+    this->separate();
+    m_buffer.push_back('{');
+
+    m_has_items[++m_depth] = false;
+}
+
+void json_writer::end_object()
+{
+    --m_depth;
+    m_buffer.push_back('}');
+}
+
+void json_writer::begin_array()
+{
+    this->separate();
+    m_buffer.push_back('[');
+
+    m_has_items[++m_depth] = false;
+}
+
+void json_writer::end_array()
+{
+    --m_depth;
+    m_buffer.push_back(']');
+}
+
+void json_writer::key(const char* name)
+{
+    this->value(name);
+    m_buffer.push_back(':');
+
+    m_after_key = true;
+}
+
+void json_writer::value(bool value)
+{
+    this->separate();
+
+    if (value)
+    {
+        m_buffer.append("true", 4);
+    }
+    else
+    {
+        m_buffer.append("false", 5);
+    }
+}
+
+void json_writer::value(float value)
+{
+    this->separate();
+    this->write_float(value);
+}
+
+void json_writer::value(uint32_t value)
+{
+    this->separate();
+    this->write_unsigned(value);
+}
+
+void json_writer::value(uint64_t value)
+{
+    this->separate();
+    this->write_unsigned(value);
+}
+
+void json_writer::value(int32_t value)
+{
+    this->separate();
+
+    if (value < 0)
+    {
+        m_buffer.push_back('-');
+        this->write_unsigned(0u - (uint32_t) value);
+    }
+    else
+    {
+        this->write_unsigned((uint32_t) value);
+    }
+}
+
+void json_writer::value(const char* value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    this->separate();
+    m_buffer.push_back('"');
+
+    // Same escapes as dump(), everything else is copied as it is
+    for (const char* c = value; *c != '\0'; ++c)
+    {
+        switch (*c)
+        {
+            case '"': m_buffer.append("\\\"", 2); break;
+            case '\\': m_buffer.append("\\\\", 2); break;
+            case '\b': m_buffer.append("\\b", 2); break;
+            case '\f': m_buffer.append("\\f", 2); break;
+            case '\n': m_buffer.append("\\n", 2); break;
+            case '\r': m_buffer.append("\\r", 2); break;
+            case '\t': m_buffer.append("\\t", 2); break;
+            default:
+                if ((uint8_t) *c < 0x20)
+                {
+                    m_buffer.append("\\u00", 4);
+                    m_buffer.push_back(hex[(uint8_t) *c >> 4]);
+                    m_buffer.push_back(hex[(uint8_t) *c & 0xf]);
+                }
+                else
+                {
+                    m_buffer.push_back(*c);
+                }
+                break;
+        }
+    }
+
+    m_buffer.push_back('"');
+}
+
+void json_writer::values(const float* values, uint32_t count)
+{
+    this->begin_array();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (i > 0)
+        {
+            m_buffer.push_back(',');
+        }
+        this->write_float(values[i]);
+    }
+
+    this->end_array();
+}
+
+void json_writer::values(const uint8_t* values, uint32_t count)
+{
+    this->begin_array();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (i > 0)
+        {
+            m_buffer.push_back(',');
+        }
+        this->write_unsigned(values[i]);
+    }
+
+    this->end_array();
+}
+
+void json_writer::write_unsigned(uint64_t value)
+{
+    char digits[20];
+    uint32_t length = 0;
+
+    do
+    {
+        digits[length++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (length > 0)
+    {
+        m_buffer.push_back(digits[--length]);
+    }
+}
+
+void json_writer::write_float(float value)
+{
+    // json keeps numbers as double, so that is what gets converted
+    double number = value;
+
+    if (!isfinite(number))
+    {
+        m_buffer.append("null", 4);
+        return;
+    }
+
+    char text[64];
+    char* end = nlohmann::detail::to_chars(text, text + sizeof(text), number);
+
+    m_buffer.append(text, end - text);
+}
+
+const char* json_writer::get_data()
+{
+    return m_buffer.data();
+}
+
+size_t json_writer::get_size()
+{
+    return m_buffer.size();
+}
@@ -0,0 +1,563 @@
+#include "legacy_capture.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+// Largest powers of ten a double holds exactly
+static const double powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+#define MAX_EXACT_POWER 22
+
+// Significant digits that fit a uint64_t
+#define MAX_MANTISSA_DIGITS 19
+
+bool parse_float(const char** text, const char* end, float* value)
+{
+    const char* p = *text;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    uint32_t digits = 0;
+    int32_t exponent = 0;
+    bool any = false;
+
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        if (digits < MAX_MANTISSA_DIGITS)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+        {
+            ++exponent;
+        }
+        any = true;
+    }
+
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            // Leading zeros only move the exponent, digits past the 19th don't change a float
+            if (digits < MAX_MANTISSA_DIGITS)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+            any = true;
+        }
+    }
+
+    if (!any)
+    {
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p + 1;
+
+        bool negative_exponent = false;
+        if (e < end && (*e == '-' || *e == '+'))
+        {
+            negative_exponent = *e == '-';
+            ++e;
+        }
+
+        if (e < end && *e >= '0' && *e <= '9')
+        {
+            int32_t written = 0;
+            for (; e < end && *e >= '0' && *e <= '9'; ++e)
+            {
+                // Way out of float range either way
+                if (written < 10000)
+                {
+                    written = written * 10 + (*e - '0');
+                }
+            }
+
+            exponent += negative_exponent ? -written : written;
+            p = e;
+        }
+    }
+
+    double result = (double) mantissa;
+
+    while (exponent > MAX_EXACT_POWER && result != 0.0 && !isinf(result))
+    {
+        result *= powers_of_ten[MAX_EXACT_POWER];
+        exponent -= MAX_EXACT_POWER;
+    }
+    while (exponent < -MAX_EXACT_POWER && result != 0.0)
+    {
+        result /= powers_of_ten[MAX_EXACT_POWER];
+        exponent += MAX_EXACT_POWER;
+    }
+
+    if (exponent > 0 && exponent <= MAX_EXACT_POWER)
+    {
+        result *= powers_of_ten[exponent];
+    }
+    else if (exponent < 0 && exponent >= -MAX_EXACT_POWER)
+    {
+        result /= powers_of_ten[-exponent];
+    }
+
+    *value = (float) (negative ? -result : result);
+    *text = p;
+
+    return true;
+}
+
+static bool read_file(const std::string& path, std::vector<char>* text)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    text->resize(size > 0 ? size : 0);
+
+    bool complete = size >= 0 && fread(text->data(), 1, text->size(), file) == text->size();
+    fclose(file);
+
+    return complete;
+}
+
+typedef struct
+{
+    const char* p;
+    const char* end;
+    uint32_t line;
+} line_reader_t;
+
+// Skips empty lines, false at the end of the text
+static bool next_line(line_reader_t* reader, const char** begin, const char** end)
+{
+    while (reader->p < reader->end)
+    {
+        const char* line_end = (const char*) memchr(reader->p, '\n', reader->end - reader->p);
+        if (line_end == nullptr)
+        {
+            line_end = reader->end;
+        }
+
+        *begin = reader->p;
+        *end = line_end;
+
+        reader->p = line_end < reader->end ? line_end + 1 : line_end;
+        ++reader->line;
+
+        if (*end > *begin && *(*end - 1) == '\r')
+        {
+            --*end;
+        }
+
+        if (*end > *begin)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// "label: value", leaves the value in rest
+static bool parse_label(const char* begin, const char* end, const char* label, const char** rest)
+{
+    size_t length = strlen(label);
+
+    if ((size_t) (end - begin) < length + 1 || memcmp(begin, label, length) != 0 || begin[length] != ':')
+    {
+        return false;
+    }
+
+    *rest = begin + length + 1;
+    while (*rest < end && **rest == ' ')
+    {
+        ++*rest;
+    }
+
+    return true;
+}
+
+static bool parse_uint(const char* begin, const char* end, uint32_t* value)
+{
+    if (begin == end)
+    {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (const char* p = begin; p < end; ++p)
+    {
+        if (*p < '0' || *p > '9' || result > UINT32_MAX)
+        {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+    }
+
+    *value = (uint32_t) result;
+
+    return result <= UINT32_MAX;
+}
+
+// A ", " separated list, appended to values. Fails on anything that isn't a finite number.
+static bool parse_values(const char* begin, const char* end, std::vector<float>* values)
+{
+    const char* p = begin;
+
+    while (true)
+    {
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+
+        if (p == end)
+        {
+            return true;
+        }
+
+        float value;
+        if (!parse_float(&p, end, &value) || !isfinite(value))
+        {
+            return false;
+        }
+        values->push_back(value);
+
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+
+        if (p < end && *p != ',')
+        {
+            return false;
+        }
+        if (p < end)
+        {
+            ++p;
+        }
+    }
+}
+
+static std::string at_line(const std::string& path, uint32_t line)
+{
+    return path + ":" + std::to_string(line) + ": ";
+}
+
+legacy_capture::legacy_capture()
+{
+
+}
+
+legacy_capture::~legacy_capture()
+{
+
+}
+
+bool legacy_capture::open(const std::string& directory, std::string* error)
+{
+    m_directory = directory;
+    m_text_size = 0;
+    m_warnings.clear();
+
+    if (!this->read_metrics(directory + "/" + LEGACY_CAPTURE_METRICS_FILE, error) ||
+        !this->read_data(directory + "/" + LEGACY_CAPTURE_DATA_FILE, error))
+    {
+        return false;
+    }
+
+    if (m_bin_interest < m_first_bin || m_bin_interest >= m_first_bin + m_num_bins)
+    {
+        m_warnings.push_back("bin of interest " + std::to_string(m_bin_interest) + " was not recorded");
+    }
+
+    return true;
+}
+
+bool legacy_capture::read_metrics(const std::string& path, std::string* error)
+{
+    std::vector<char> text;
+    if (!read_file(path, &text))
+    {
+        *error = "can't read " + path;
+        return false;
+    }
+    m_text_size += text.size();
+
+    line_reader_t reader = {text.data(), text.data() + text.size(), 0};
+
+    const char* begin;
+    const char* end;
+    const char* rest;
+
+    if (!next_line(&reader, &begin, &end) || !parse_label(begin, end, "range_resolution", &rest) ||
+        !parse_float(&rest, end, &m_range_resolution) || rest != end || !(m_range_resolution > 0.0f))
+    {
+        *error = at_line(path, reader.line) + "expected a positive range_resolution";
+        return false;
+    }
+
+    if (!next_line(&reader, &begin, &end) || !parse_label(begin, end, "range_interest", &rest) ||
+        !parse_float(&rest, end, &m_range_interest) || rest != end)
+    {
+        *error = at_line(path, reader.line) + "expected range_interest";
+        return false;
+    }
+
+    if (!next_line(&reader, &begin, &end) || !parse_label(begin, end, "bin_interest", &rest) ||
+        !parse_uint(rest, end, &m_bin_interest))
+    {
+        *error = at_line(path, reader.line) + "expected bin_interest";
+        return false;
+    }
+
+    std::vector<float> axis;
+    if (!next_line(&reader, &begin, &end) || !parse_values(begin, end, &axis) || axis.size() < 2)
+    {
+        *error = at_line(path, reader.line) + "expected the time axis";
+        return false;
+    }
+
+    double step = (double) axis[1] - axis[0];
+    if (!(step > 0.0))
+    {
+        *error = at_line(path, reader.line) + "the time axis doesn't increase";
+        return false;
+    }
+
+    for (size_t i = 2; i < axis.size(); ++i)
+    {
+        double expected = axis[0] + i * step;
+
+        if (fabs(axis[i] - expected) > LEGACY_CAPTURE_AXIS_TOLERANCE * std::max(fabs(expected), step))
+        {
+            *error = at_line(path, reader.line) + "time " + std::to_string(i) + " is " + std::to_string(axis[i]) +
+                     ", not evenly spaced";
+            return false;
+        }
+    }
+
+    m_frame_rate = (float) (1.0 / step);
+    m_num_points = (uint32_t) axis.size();
+
+    return true;
+}
+
+bool legacy_capture::read_data(const std::string& path, std::string* error)
+{
+    std::vector<char> text;
+    if (!read_file(path, &text))
+    {
+        *error = "can't read " + path;
+        return false;
+    }
+    m_text_size += text.size();
+
+    line_reader_t reader = {text.data(), text.data() + text.size(), 0};
+
+    m_real.clear();
+    m_imag.clear();
+    m_num_bins = 0;
+
+    uint32_t num_blocks = 0;
+
+    const char* begin;
+    const char* end;
+    const char* rest;
+
+    while (next_line(&reader, &begin, &end))
+    {
+        uint32_t bin;
+        if (!parse_label(begin, end, "curr_bin", &rest) || !parse_uint(rest, end, &bin))
+        {
+            *error = at_line(path, reader.line) + "expected curr_bin";
+            return false;
+        }
+
+        // The first pass ends where the bins stop counting up
+        if (num_blocks == 0)
+        {
+            m_first_bin = bin;
+        }
+        else if (m_num_bins == 0 && bin != m_first_bin + num_blocks)
+        {
+            m_num_bins = num_blocks;
+        }
+
+        uint32_t expected_bin = m_num_bins == 0 ? m_first_bin + num_blocks : m_first_bin + num_blocks % m_num_bins;
+        if (bin != expected_bin)
+        {
+            *error = at_line(path, reader.line) + "bin " + std::to_string(bin) + " where " + std::to_string(expected_bin) + " was expected";
+            return false;
+        }
+
+        const char* labels[] = {"real", "imag"};
+        std::vector<float>* columns[] = {&m_real, &m_imag};
+
+        for (uint32_t column = 0; column < 2; ++column)
+        {
+            uint32_t label_bin;
+            if (!next_line(&reader, &begin, &end) || !parse_label(begin, end, labels[column], &rest) ||
+                !parse_uint(rest, end, &label_bin) || label_bin != bin)
+            {
+                *error = at_line(path, reader.line) + "expected " + labels[column] + ": " + std::to_string(bin);
+                return false;
+            }
+
+            size_t before = columns[column]->size();
+
+            if (!next_line(&reader, &begin, &end) || !parse_values(begin, end, columns[column]))
+            {
+                *error = at_line(path, reader.line) + "expected finite " + labels[column] + " values";
+                return false;
+            }
+
+            if (columns[column]->size() - before != m_num_points)
+            {
+                *error = at_line(path, reader.line) + std::to_string(columns[column]->size() - before) + " " + labels[column] +
+                         " values, the time axis has " + std::to_string(m_num_points);
+                return false;
+            }
+        }
+
+        ++num_blocks;
+    }
+
+    if (num_blocks == 0)
+    {
+        *error = path + " has no bins";
+        return false;
+    }
+
+    if (m_num_bins == 0)
+    {
+        m_num_bins = num_blocks;
+    }
+
+    if (num_blocks % m_num_bins != 0)
+    {
+        *error = path + " ends in the middle of a pass";
+        return false;
+    }
+
+    m_num_passes = num_blocks / m_num_bins;
+
+    return true;
+}
+
+void legacy_capture::write_recording(slow_time_recorder* recorder)
+{
+    json metrics;
+    metrics["range_resolution"] = m_range_resolution;
+    metrics["range_interest"] = m_range_interest;
+    metrics["bin_interest"] = m_bin_interest;
+    metrics["frame_rate"] = m_frame_rate;
+    metrics["source"] = m_directory;
+
+    recorder->begin(metrics, m_first_bin, m_num_bins, m_num_points);
+
+    std::vector<float> real(m_num_bins);
+    std::vector<float> imag(m_num_bins);
+
+    double period_us = 1e6 / m_frame_rate;
+
+    // Passes follow each other without a gap, the text has no times of its own
+    for (uint32_t pass = 0; pass < m_num_passes; ++pass)
+    {
+        for (uint32_t i = 0; i < m_num_points; ++i)
+        {
+            for (uint32_t bin_index = 0; bin_index < m_num_bins; ++bin_index)
+            {
+                real[bin_index] = this->get_real(pass, bin_index)[i];
+                imag[bin_index] = this->get_imag(pass, bin_index)[i];
+            }
+
+            uint32_t sequence = pass * m_num_points + i;
+            recorder->add_row((uint64_t) llround(sequence * period_us), sequence, real.data(), imag.data());
+        }
+    }
+
+    recorder->flush();
+}
+
+float legacy_capture::get_range_resolution()
+{
+    return m_range_resolution;
+}
+
+float legacy_capture::get_range_interest()
+{
+    return m_range_interest;
+}
+
+uint32_t legacy_capture::get_bin_interest()
+{
+    return m_bin_interest;
+}
+
+float legacy_capture::get_frame_rate()
+{
+    return m_frame_rate;
+}
+
+uint32_t legacy_capture::get_first_bin()
+{
+    return m_first_bin;
+}
+
+uint32_t legacy_capture::get_num_bins()
+{
+    return m_num_bins;
+}
+
+uint32_t legacy_capture::get_num_points()
+{
+    return m_num_points;
+}
+
+uint32_t legacy_capture::get_num_passes()
+{
+    return m_num_passes;
+}
+
+const float* legacy_capture::get_real(uint32_t pass, uint32_t bin_index)
+{
+    return &m_real[((size_t) pass * m_num_bins + bin_index) * m_num_points];
+}
+
+const float* legacy_capture::get_imag(uint32_t pass, uint32_t bin_index)
+{
+    return &m_imag[((size_t) pass * m_num_bins + bin_index) * m_num_points];
+}
+
+size_t legacy_capture::get_text_size()
+{
+    return m_text_size;
+}
+
+const std::vector<std::string>& legacy_capture::get_warnings()
+{
+    return m_warnings;
+}
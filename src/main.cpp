@@ -7,6 +7,21 @@
 #include "dsp.hpp"
 #include "radar_control.hpp"
 #include "radar_config.hpp"
+#include "frame_rate_control.hpp"
+#include "config_watcher.hpp"
+#include "frame_source.hpp"
+#include "synthetic_source.hpp"
+#include "replay_source.hpp"
+#include "frame_recorder.hpp"
+#include "slow_time_recorder.hpp"
+#include "thread_pool.hpp"
+#include "packet.hpp"
+#include "packet_sender.hpp"
+#include "udp_streamer.hpp"
+#include "shm_ring.hpp"
+#include "connection.hpp"
+#include "subscriber_server.hpp"
+#include "encoding.hpp"
 
 #include <boost/asio.hpp>
 
@@ -17,9 +32,14 @@
 #include <windows.h>
 #endif
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <vector>
 
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
@@ -90,111 +110,727 @@ void send_string(int sock, string data)
 
 auto LogPrinter = [](const std::string& strLogMsg) { std::cout << strLogMsg << std::endl;  };
 
+// Stages somebody is subscribed to, nothing else needs to run
+uint32_t subscribed_stages(const std::vector<connection*>& connections)
+{
+    uint32_t stages = 0;
+
+    for (connection* receiver : connections)
+    {
+        stages |= receiver->get_topics();
+    }
+
+    return stages;
+}
+
+void send_configs(const std::vector<connection*>& connections, radar_config* rc)
+{
+    for (connection* receiver : connections)
+    {
+        receiver->send_config(rc);
+    }
+}
+
+// Every distinct output is encoded once, receivers that want the same get the same bytes
+void send_frames(const std::vector<connection*>& connections, dsp* dsp_chain, uint32_t sequence, uint64_t timestamp_us, bool droppable)
+{
+    std::vector<connection*> encoded;
+
+    for (connection* receiver : connections)
+    {
+        if (!receiver->wants_frame(sequence))
+        {
+            continue;
+        }
+
+        connection* shared = nullptr;
+        for (connection* other : encoded)
+        {
+            if (other->same_output(receiver))
+            {
+                shared = other;
+                break;
+            }
+        }
+
+        receiver->send_frame(dsp_chain, sequence, timestamp_us, droppable, shared);
+
+        if (shared == nullptr)
+        {
+            encoded.push_back(receiver);
+        }
+    }
+}
+
+// Comma separated list of unsigned numbers, false on anything else
+bool parse_list(const string& text, std::vector<uint32_t>* values)
+{
+    std::stringstream stream(text);
+    string item;
+
+    while (std::getline(stream, item, ','))
+    {
+        if (item.empty() || item.find_first_not_of("0123456789") != string::npos)
+        {
+            return false;
+        }
+        values->push_back((uint32_t) std::stoul(item));
+    }
+
+    return true;
+}
+
+// Comma separated stage names to dsp_stage_t flags, false on an unknown name
+bool parse_stages(const string& text, uint32_t* stages)
+{
+    std::stringstream stream(text);
+    string item;
+
+    *stages = 0;
+
+    while (std::getline(stream, item, ','))
+    {
+        uint32_t stage;
+
+        if (!dsp::parse_stage(item, &stage))
+        {
+            return false;
+        }
+        *stages |= stage;
+    }
+
+    return true;
+}
+
 int main(int argc, char** argv)
 {
-    if (argc < 2) {
-        cerr << "Missing second argument (ip address)." << endl;
-        cerr << "./radar_sdk <192.168.0.1>" << endl;
+    string host;
+    uint16_t port;
+    unsigned int timeout_milli;
+    string source_name;
+    string replay_path;
+    string record_path;
+    string slow_time_path;
+    string stages_text;
+    string encoding_name;
+    string compression_name;
+    float max_error_db;
+    float dynamic_range_db;
+    bool listen_mode;
+    uint32_t divisor;
+    string transport;
+    uint32_t mtu;
+    uint32_t ttl;
+    string shm_name;
+    uint32_t shm_slots;
+    uint32_t shm_slot_bytes;
+    string tcp_mode_name;
+    string drop_policy_name;
+    size_t max_queue_bytes;
+    bool reconnect;
+    size_t backlog_bytes;
+    uint32_t num_threads;
+    string cpus_text;
+    string config_path;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("host", po::value<string>(&host), "address of the server receiving the data, or udp destination")
+        ("port,p", po::value<uint16_t>(&port)->default_value(4242), "server port")
+        ("timeout", po::value<unsigned int>(&timeout_milli)->default_value(5000), "connect timeout in ms")
+        ("source,s", po::value<string>(&source_name)->default_value("device"), "frame source: device, replay or synthetic")
+        ("replay-file", po::value<string>(&replay_path), "raw frame capture played back by the replay source")
+        ("loop", "start the replay over at the end of the capture")
+        ("free-run", "don't pace replay / synthetic frames to the frame rate")
+        ("record-frames", po::value<string>(&record_path), "write every raw frame to this capture file")
+        ("record-slow-time", po::value<string>(&slow_time_path),
+            "append the slow-time bins and their spectra to this recording, runs the slow_time stage while presence is confirmed")
+        ("stages", po::value<string>(&stages_text)->default_value("frame,slow_time,tracks,spectrogram"),
+            "dsp stages: frame, slow_time, tracks, spectrogram, azimuth, elevation. Subscribers choose their own.")
+        ("encoding,e", po::value<string>(&encoding_name)->default_value("binary"), "packet encoding: binary, json, msgpack, cbor or ubjson")
+        ("compression", po::value<string>(&compression_name)->default_value("none"),
+            "lossy compression of maps and spectra in the binary encoding: none, db16 or db8")
+        ("max-error-db", po::value<float>(&max_error_db)->default_value(PAYLOAD_CODEC_DEFAULT_MAX_ERROR_DB), "compression error bound in dB")
+        ("dynamic-range-db", po::value<float>(&dynamic_range_db)->default_value(PAYLOAD_CODEC_DEFAULT_DYNAMIC_RANGE_DB),
+            "compressed values further below the peak are sent as the floor")
+        ("listen,l", po::bool_switch(&listen_mode), "accept subscribers on port instead of connecting to host")
+        ("divisor", po::value<uint32_t>(&divisor)->default_value(1), "send every n-th frame, subscribers choose their own")
+        ("transport", po::value<string>(&transport)->default_value("tcp"),
+            "tcp connects to the server, udp streams datagrams to host, which may be a multicast group, "
+            "shm writes to a shared memory ring for readers on this machine")
+        ("mtu", po::value<uint32_t>(&mtu)->default_value(UDP_DEFAULT_MTU), "udp datagram size limit")
+        ("ttl", po::value<uint32_t>(&ttl)->default_value(1), "udp multicast hops")
+        ("shm-name", po::value<string>(&shm_name)->default_value(SHM_RING_DEFAULT_NAME), "shared memory ring name")
+        ("shm-slots", po::value<uint32_t>(&shm_slots)->default_value(SHM_RING_DEFAULT_SLOTS), "messages the ring holds, a power of two")
+        ("shm-slot-bytes", po::value<uint32_t>(&shm_slot_bytes)->default_value(SHM_RING_DEFAULT_SLOT_BYTES), "largest message that fits the ring")
+        ("tcp-mode", po::value<string>(&tcp_mode_name)->default_value("nodelay"),
+            "nodelay sends every write at once, nagle keeps the kernel default, cork sends full segments")
+        ("drop-policy", po::value<string>(&drop_policy_name)->default_value("oldest"),
+            "what gives when the send queue is full: oldest, newest or coalesce")
+        ("queue-bytes", po::value<size_t>(&max_queue_bytes)->default_value(PACKET_SENDER_DEFAULT_QUEUE_BYTES), "send queue limit in bytes")
+        ("reconnect", po::bool_switch(&reconnect), "keep running when the server goes away and connect again once it is back")
+        ("backlog-bytes", po::value<size_t>(&backlog_bytes)->default_value(0),
+            "with --reconnect, replay up to this many bytes of the last sent frames to the new connection")
+        ("threads,t", po::value<uint32_t>(&num_threads)->default_value(DSP_DEFAULT_NUM_THREADS), "dsp threads, 0 for one per core")
+        ("cpus", po::value<string>(&cpus_text), "cpus to pin to, e.g. 1,2,3. The first one takes acquisition and dsp worker 0.")
+        ("config,c", po::value<string>(&config_path)->default_value(RADAR_CONFIG_DEFAULT_PATH), "config file, reloaded on change");
+
+    po::positional_options_description positional;
+    positional.add("host", 1);
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        cerr << "Example usage: ./radar_sdk 192.168.0.1 --source synthetic" << endl;
+        return 1;
+    }
+
+    if (vm.count("help"))
+    {
+        cout << "Usage: ./radar_sdk <host> [options]" << endl << options << endl;
+        return 0;
+    }
+
+    if (host.empty() && !listen_mode && transport != "shm")
+    {
+        cerr << "Missing server address." << endl;
+        cerr << "Example usage: ./radar_sdk 192.168.0.1" << endl;
         return 1;
-    } else if (argc > 2)  {
-        cerr << "Too many arguments!" << endl;
-        cerr << "Example usage: ./radar_sdk <192.168.0.1>" << endl;
+    }
+
+    encoding_t encoding;
+    if (!parse_encoding(encoding_name, &encoding))
+    {
+        cerr << "Unknown encoding " << encoding_name << endl;
+        return 1;
+    }
+
+    compression_t compression;
+    if (!parse_compression(compression_name, &compression) || max_error_db <= 0.0f || dynamic_range_db <= 0.0f)
+    {
+        cerr << "Bad compression " << compression_name << ", " << max_error_db << " dB error, " << dynamic_range_db << " dB range" << endl;
+        return 1;
+    }
+
+    if (compression != COMPRESSION_NONE && encoding != ENCODING_BINARY)
+    {
+        cerr << "Compression only applies to the binary encoding, sending " << encoding_name << " uncompressed" << endl;
+    }
+
+    if (transport != "tcp" && transport != "udp" && transport != "shm")
+    {
+        cerr << "Unknown transport " << transport << endl;
+        return 1;
+    }
+
+    if (mtu <= UDP_IP_OVERHEAD + sizeof(udp_fragment_header_t))
+    {
+        cerr << "MTU too small" << endl;
+        return 1;
+    }
+
+    tcp_mode_t tcp_mode;
+    if (tcp_mode_name == "nodelay")
+    {
+        tcp_mode = TCP_MODE_NODELAY;
+    }
+    else if (tcp_mode_name == "nagle")
+    {
+        tcp_mode = TCP_MODE_NAGLE;
+    }
+    else if (tcp_mode_name == "cork")
+    {
+        tcp_mode = TCP_MODE_CORK;
+    }
+    else
+    {
+        cerr << "Unknown tcp mode " << tcp_mode_name << endl;
+        return 1;
+    }
+
+    drop_policy_t drop_policy;
+    if (drop_policy_name == "oldest")
+    {
+        drop_policy = DROP_POLICY_OLDEST;
+    }
+    else if (drop_policy_name == "newest")
+    {
+        drop_policy = DROP_POLICY_NEWEST;
+    }
+    else if (drop_policy_name == "coalesce")
+    {
+        drop_policy = DROP_POLICY_COALESCE;
+    }
+    else
+    {
+        cerr << "Unknown drop policy " << drop_policy_name << endl;
+        return 1;
+    }
+
+    uint32_t stages;
+    if (!parse_stages(stages_text, &stages))
+    {
+        cerr << "Unknown stage in " << stages_text << endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> cpus;
+    if (!parse_list(cpus_text, &cpus))
+    {
+        cerr << "Can't read the cpu list " << cpus_text << endl;
+        return 1;
+    }
+
+    if (source_name != "device" && source_name != "replay" && source_name != "synthetic")
+    {
+        cerr << "Unknown source " << source_name << endl;
+        return 1;
+    }
+
+    if (source_name == "replay" && replay_path.empty())
+    {
+        cerr << "The replay source needs --replay-file" << endl;
         return 1;
     }
 
     signal(SIGINT, signal_handle);
 
+    if (!cpus.empty() && !::thread_pool::pin_current_thread(cpus[0]))
+    {
+        cerr << "Can't pin to cpu " << cpus[0] << endl;
+    }
+
     cout << "Running Radar SDK version: " << ifx_radar_sdk_get_version_string() << endl;
 
-    cout << "Creating device handle and dsp chain" << endl;
+    cout << "Creating " << source_name << " source and dsp chain" << endl;
 
     radar_config rc;
 
-    cout << "Connecting to server " << argv[1] << ":4242" << endl;
+    string config_error;
+    if (!rc.load_file(config_path, &config_error))
+    {
+        cerr << "Using default configuration, " << config_path << ": " << config_error << endl;
+    }
+
+    frame_source* source;
+
+    if (source_name == "device")
+    {
+        source = new radar_control(&rc);
+    }
+    else if (source_name == "synthetic")
+    {
+        synthetic_source* synthetic = new synthetic_source(&rc);
+
+        string synthetic_error;
+        if (!synthetic->open(&synthetic_error))
+        {
+            cerr << synthetic_error << endl;
+            delete synthetic;
+            return 1;
+        }
+
+        source = synthetic;
+    }
+    else
+    {
+        replay_source* replay = new replay_source(&rc);
+
+        string replay_error;
+        if (!replay->open(replay_path, &replay_error))
+        {
+            cerr << replay_error << endl;
+            delete replay;
+            return 1;
+        }
+
+        replay->set_loop(vm.count("loop") > 0);
+        source = replay;
+    }
+
+    source->set_paced(vm.count("free-run") == 0);
+
+    frame_recorder* recorder = nullptr;
+
+    if (!record_path.empty())
+    {
+        recorder = new frame_recorder(&rc);
+
+        string record_error;
+        if (!recorder->open(record_path, &record_error))
+        {
+            cerr << record_error << endl;
+            delete recorder;
+            recorder = nullptr;
+        }
+    }
+
+    slow_time_recorder* slow_time = nullptr;
+
+    // The recording needs the stage whether anybody is sent it or not
+    uint32_t recorded_stages = 0;
+
+    if (!slow_time_path.empty())
+    {
+        slow_time = new slow_time_recorder();
+
+        string record_error;
+        if (!slow_time->open(slow_time_path, &record_error))
+        {
+            cerr << record_error << endl;
+            delete slow_time;
+            slow_time = nullptr;
+        }
+        else
+        {
+            recorded_stages = DSP_STAGE_SLOW_TIME;
+        }
+    }
+
+    std::vector<connection*> connections;
+    subscriber_server* server = nullptr;
+
+    if (listen_mode)
+    {
+        server = new subscriber_server(port, tcp_mode, drop_policy, max_queue_bytes, timeout_milli);
+        server->set_compression_bounds(max_error_db, dynamic_range_db);
+
+        string listen_error;
+        if (!server->open(&listen_error))
+        {
+            cerr << "Can't listen on port " << port << ": " << listen_error << endl;
+
+            delete server;
+            delete recorder;
+            delete slow_time;
+            delete source;
+            return 1;
+        }
+
+        cout << "Waiting for subscribers on port " << port << endl;
+
+        // Nothing but the presence tier runs until somebody subscribes
+        stages = 0;
+    }
+    else if (transport == "udp")
+    {
+        udp_streamer* streamer = new udp_streamer(mtu, ttl);
+
+        string open_error;
+        if (!streamer->open(host, port, &open_error))
+        {
+            cerr << "Can't stream to " << host << ":" << port << ": " << open_error << endl;
+
+            delete streamer;
+            delete recorder;
+            delete slow_time;
+            delete source;
+            return 1;
+        }
+
+        cout << "Streaming to " << (streamer->is_multicast() ? "group " : "") << host << ":" << port << endl;
+
+        connections.push_back(new connection(streamer, encoding, stages, divisor));
+        connections.back()->set_config_interval(UDP_STREAMER_CONFIG_INTERVAL_MS);
+    }
+    else if (transport == "shm")
+    {
+        shm_ring_writer* ring = new shm_ring_writer(shm_name, shm_slots, shm_slot_bytes);
+
+        string open_error;
+        if (!ring->open(&open_error))
+        {
+            cerr << "Can't create ring " << shm_name << ": " << open_error << endl;
+
+            delete ring;
+            delete recorder;
+            delete slow_time;
+            delete source;
+            return 1;
+        }
+
+        cout << "Writing to shared memory ring " << shm_name << endl;
 
-    boost::asio::io_service io_service;
+        connections.push_back(new connection(ring, encoding, stages, divisor));
+        connections.back()->set_config_interval(SHM_RING_CONFIG_INTERVAL_MS);
+    }
+    else
+    {
+        cout << "Connecting to server " << host << ":" << port << endl;
 
-    tcp::socket socket(io_service);
+        packet_sender* sender = new packet_sender(tcp_mode, drop_policy, max_queue_bytes);
 
-    // the timeout value
-    unsigned int timeout_milli = 5000;
+        if (reconnect)
+        {
+            sender->set_reconnect(backlog_bytes);
+        }
 
-    // platform-specific switch
-    #if defined _WIN32 || defined WIN32 || defined OS_WIN64 || defined _WIN64 || defined WIN64 || defined WINNT
-        // use windows-specific time
-      int32_t timeout = timeout_milli;
-      setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
-      setsockopt(socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
-    #else
-        // assume everything else is posix
-        struct timeval tv;
-        tv.tv_sec  = timeout_milli / 1000;
-        tv.tv_usec = (timeout_milli % 1000) * 1000;
-        setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-        setsockopt(socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-    #endif
+        string connect_error;
+        bool connected = sender->connect(host, port, timeout_milli, &connect_error);
 
-    socket.connect( tcp::endpoint( boost::asio::ip::address::from_string(argv[1]), 4242 ));
-    boost::system::error_code error;
+        if (!connected && reconnect && !sender->failed())
+        {
+            cerr << "Failed to connect: " << connect_error << ", retrying in the background" << endl;
 
-    json config;
-    config["packet_type"] = "configuration";
-    config["sdk_version"] = ifx_radar_sdk_get_version_string();
-    config["config"] = rc.create_json();
+            sender->start_reconnect();
+        }
+        else if (!connected)
+        {
+            cerr << "Failed to connect: " << connect_error << endl;
 
-    radar_control radar_control(&rc);
+            delete sender;
+            delete recorder;
+            delete slow_time;
+            delete source;
+            return 1;
+        }
 
-    dsp dsp(&rc);
+        connections.push_back(new connection(sender, encoding, stages, divisor));
+    }
 
-    string config_str = config.dump();
+    for (connection* receiver : connections)
+    {
+        receiver->set_compression(compression, max_error_db, dynamic_range_db);
+    }
+
+    dsp* dsp_chain = new dsp(&rc, num_threads, cpus);
+    dsp_chain->set_stages(stages | recorded_stages);
+
+    if (dsp_chain->failed())
+    {
+        cerr << "Can't set up the dsp: " << dsp_chain->get_error() << endl;
+        running = false;
+    }
+
+    if (slow_time != nullptr)
+    {
+        dsp_chain->write_slow_time_schema(slow_time);
+    }
+
+    frame_rate_control frame_rate_control(&rc);
+
+    config_watcher config_watcher(config_path, &rc);
 
     cout << "Sending configuration file" << endl;
 
-    uint32_t len = config_str.length();
-    boost::asio::write( socket, boost::asio::buffer(&len, 4), error );
-    boost::asio::write( socket, boost::asio::buffer(config_str), error );
+    send_configs(connections, &rc);
 
     cout << "Starting loop" << endl;
 
+    cout << "Running " << (dsp_chain->is_specialised() ? "specialised" : "generic") << " dsp on " << dsp_chain->get_num_threads() << " threads" << endl;
+
     ifx_Error_t ret = IFX_OK;
 
     int x = 0;
+    uint64_t dsp_time_us = 0;
+    uint32_t sequence = 0;
 	while (running)
     {
-        ret = radar_control.pull_frame();
+        // Frame boundary, nothing holds on to the live config here
+        radar_config* next_config = config_watcher.take_pending();
+
+        if (next_config != nullptr)
+        {
+            cout << "Applying changed " << config_path << endl;
+
+            bool same_dimensions = rc.same_dimensions(next_config);
+
+            rc = *next_config;
+            delete next_config;
+
+            // The source has nothing valid left to hand out
+            if (source->reconfigure() != IFX_OK)
+            {
+                cerr << "Failed to reconfigure " << source_name << " source, stopping" << endl;
+                break;
+            }
+
+            if (same_dimensions)
+            {
+                dsp_chain->update_config();
+            }
+            else
+            {
+                delete dsp_chain;
+                dsp_chain = new dsp(&rc, num_threads, cpus);
+                dsp_chain->set_stages(stages | recorded_stages);
+            }
+
+            if (dsp_chain->failed())
+            {
+                cerr << "Can't set up the dsp for " << config_path << ": " << dsp_chain->get_error() << endl;
+                break;
+            }
+
+            if (slow_time != nullptr)
+            {
+                dsp_chain->write_slow_time_schema(slow_time);
+            }
+
+            frame_rate_control.reset();
+
+            send_configs(connections, &rc);
+
+            x = 0;
+            dsp_time_us = 0;
+        }
+
+        for (connection* receiver : connections)
+        {
+            if (receiver->config_due())
+            {
+                receiver->send_config(&rc);
+            }
+        }
+
+        if (server != nullptr)
+        {
+            std::vector<connection*> subscribers = server->take_new();
+
+            for (connection* subscriber : subscribers)
+            {
+                cout << "New " << get_encoding_name(subscriber->get_encoding()) << " subscriber, every "
+                     << subscriber->get_divisor() << ". frame" << endl;
+
+                subscriber->send_config(&rc);
+                connections.push_back(subscriber);
+            }
+
+            // Subscribers that went away take their stages with them
+            for (std::vector<connection*>::iterator it = connections.begin(); it != connections.end(); )
+            {
+                if ((*it)->get_sink()->failed())
+                {
+                    cout << "Subscriber gone: " << (*it)->get_sink()->get_error() << endl;
+
+                    delete *it;
+                    it = connections.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            if (subscribed_stages(connections) != stages)
+            {
+                stages = subscribed_stages(connections);
+                dsp_chain->set_stages(stages | recorded_stages);
+            }
+        }
+
+        ret = source->pull_frame();
+
+        if (source->finished())
+        {
+            cout << "End of " << source_name << " source" << endl;
+            break;
+        }
 
         if (ret != IFX_OK)
         {
             continue;
         }
 
-        ifx_Frame_t frame = radar_control.get_frame();
+        ifx_Frame_t frame = source->get_frame();
 
+        uint64_t frame_time_us = packet_time_us();
 
+        if (recorder != nullptr)
+        {
+            recorder->write(&frame);
+        }
 
-        json data;
-        data["packet_type"] = "data";
-        data["data"] = dsp.run(frame);
+        dsp_chain->process(frame);
+        dsp_time_us += dsp_chain->get_last_run_time_us();
 
-        string data_str = data.dump();
-        uint32_t length = data_str.length();
+        if (slow_time != nullptr)
+        {
+            dsp_chain->write_slow_time(slow_time, sequence, frame_time_us);
+        }
 
-        uint32_t len = data_str.length();
-        boost::asio::write( socket, boost::asio::buffer(&len, 4), error );
-        boost::asio::write( socket, boost::asio::buffer(data_str), error );
+        if (frame_rate_control.update(dsp_chain->motion_detected()))
+        {
+            cout << "Changing frame rate to " << frame_rate_control.get_frame_rate() << " Hz" << endl;
+
+            rc.set_frame_rate(frame_rate_control.get_frame_rate());
+
+            // The frame rate is part of the metrics
+            if (slow_time != nullptr)
+            {
+                dsp_chain->write_slow_time_schema(slow_time);
+            }
+
+            // The source has nothing valid left to hand out
+            if (source->reconfigure() != IFX_OK)
+            {
+                cerr << "Failed to reconfigure " << source_name << " source, stopping" << endl;
+                break;
+            }
+        }
 
-        int fr = rc.get_device_metrics()->m_frame_rate * 2;
+        // Empty scene, only the presence transitions are worth sending, and those must not get lost
+        if (dsp_chain->is_presence_confirmed() || dsp_chain->presence_changed())
+        {
+            bool droppable = !dsp_chain->presence_changed();
+
+            send_frames(connections, dsp_chain, sequence, frame_time_us, droppable);
+        }
+
+        ++sequence;
+
+        if (server == nullptr && connections[0]->get_sink()->failed())
+        {
+            cerr << "Connection lost: " << connections[0]->get_sink()->get_error() << endl;
+            break;
+        }
+
+        // Reports every two seconds, validate keeps the rate high enough for this to be positive
+        int fr = std::max(1, (int) (rc.get_device_metrics()->m_frame_rate * 2));
 
         if (x == 0)
         {
-            cout << "Sending data..." << endl;
+            cout << (dsp_chain->is_presence_confirmed() ? "Sending data..." : "Waiting for presence...") << endl;
         }
 
         ++x;
+
+        if (x == fr)
+        {
+            cout << "Average dsp latency: " << dsp_time_us / fr << " us" << endl;
+            dsp_time_us = 0;
+
+            for (connection* receiver : connections)
+            {
+                packet_sink_stats_t stats = receiver->get_sink()->get_stats();
+                cout << "Sent " << stats.sent_bytes << " bytes, " << stats.queued_bytes << " queued, "
+                     << stats.dropped_bytes << " dropped in " << stats.dropped_messages << " frames, "
+                     << stats.reconnects << " reconnects" << endl;
+            }
+        }
+
         x %= fr;
     }
 
 	cout << "Closing connection" << endl;
 
+    delete server;
+    for (connection* receiver : connections)
+    {
+        delete receiver;
+    }
+    delete dsp_chain;
+    delete recorder;
+    delete slow_time;
+    delete source;
+
     return 0;
 }
@@ -27,55 +27,59 @@ mti::~mti()
     delete[] m_slow_time_buffer;
 }
 
-void mti::train(ifx_Matrix_C_t* range_fft)
+void mti::train(ifx_Matrix_C_t* range_fft, uint32_t bin)
 {
-    int buffer_index = 0;
-    for (int i = m_bin_min; i <= m_bin_max; ++i, ++buffer_index)
-    {
-        ifx_Complex_t element;
+    uint32_t buffer_index = bin - m_bin_min;
 
-        // Note zero to always take first chirp. This can be changed to include all chirps etc
-        ifx_matrix_get_element_c(range_fft, 0, i, &element);
+    ifx_Complex_t element;
 
-        // Use circular buffer to generate average
-        m_slow_time_buffer[buffer_index].data[m_buff_location[buffer_index]].data[REAL] = element.data[REAL];
-        m_slow_time_buffer[buffer_index].data[m_buff_location[buffer_index]].data[IMAG] = element.data[IMAG];
+    // Note zero to always take first chirp. This can be changed to include all chirps etc
+    ifx_matrix_get_element_c(range_fft, 0, bin, &element);
 
-        m_buff_location[buffer_index] += 1;
-        m_buff_location[buffer_index] %= m_buffer_length;
-    }
+    // Use circular buffer to generate average
+    m_slow_time_buffer[buffer_index].data[m_buff_location[buffer_index]].data[REAL] = element.data[REAL];
+    m_slow_time_buffer[buffer_index].data[m_buff_location[buffer_index]].data[IMAG] = element.data[IMAG];
+
+    m_buff_location[buffer_index] += 1;
+    m_buff_location[buffer_index] %= m_buffer_length;
 }
 
 #include <iostream>
 
 void mti::train_average(ifx_Matrix_C_t* range_fft)
 {
-    this->train(range_fft);
-
-    int buffer_index = 0;
-    for (int i = m_bin_min; i <= m_bin_max; ++i, ++buffer_index)
+    for (uint32_t i = m_bin_min; i <= m_bin_max; ++i)
     {
-        float avg_real = 0.0f;
-        float avg_imag = 0.0f;
+        this->train_average_bin(range_fft, i);
+    }
+}
 
-        for (int x = 0; x < m_buffer_length; ++x)
-        {
-            avg_real += m_slow_time_buffer[buffer_index].data[x].data[REAL];
-            avg_imag += m_slow_time_buffer[buffer_index].data[x].data[IMAG];
-        }
+void mti::train_average_bin(ifx_Matrix_C_t* range_fft, uint32_t bin)
+{
+    this->train(range_fft, bin);
 
-        avg_real /= m_buffer_length;
-        avg_imag /= m_buffer_length;
+    uint32_t buffer_index = bin - m_bin_min;
 
-        //std::cout << avg_real << std::endl;
+    float avg_real = 0.0f;
+    float avg_imag = 0.0f;
 
-        ifx_Complex_t element;
+    for (int x = 0; x < m_buffer_length; ++x)
+    {
+        avg_real += m_slow_time_buffer[buffer_index].data[x].data[REAL];
+        avg_imag += m_slow_time_buffer[buffer_index].data[x].data[IMAG];
+    }
 
-        ifx_matrix_get_element_c(range_fft, 0, i, &element);
+    avg_real /= m_buffer_length;
+    avg_imag /= m_buffer_length;
 
-        element.data[REAL] -= avg_real;
-        element.data[IMAG] -= avg_imag;
+    //std::cout << avg_real << std::endl;
 
-        ifx_matrix_set_element_c(range_fft, 0, i, element);
-    }
-}
\ No newline at end of file
+    ifx_Complex_t element;
+
+    ifx_matrix_get_element_c(range_fft, 0, bin, &element);
+
+    element.data[REAL] -= avg_real;
+    element.data[IMAG] -= avg_imag;
+
+    ifx_matrix_set_element_c(range_fft, 0, bin, element);
+}
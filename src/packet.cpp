@@ -0,0 +1,190 @@
+#include "packet.hpp"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <chrono>
+
+uint64_t packet_time_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void packet_stamp_send(uint8_t* message, size_t length, uint64_t send_time_us)
+{
+    size_t offset = 0;
+    packet_header_t header;
+
+    while (offset + sizeof(header) <= length)
+    {
+        memcpy(&header, message + offset, sizeof(header));
+
+        if (header.magic != PACKET_MAGIC)
+        {
+            return;
+        }
+
+        uint32_t send_us = (uint32_t) (send_time_us - header.timestamp_us);
+        memcpy(message + offset + offsetof(packet_header_t, send_us), &send_us, sizeof(send_us));
+
+        offset += sizeof(header) + header.payload_length;
+    }
+}
+
+packet_writer::packet_writer()
+{
+
+}
+
+packet_writer::~packet_writer()
+{
+    //dtor
+}
+
+void packet_writer::begin(uint32_t sequence, uint64_t timestamp_us, uint64_t dsp_done_us)
+{
+    m_sequence = sequence;
+    m_timestamp_us = timestamp_us;
+    m_dsp_done_us = dsp_done_us;
+
+    m_size = 0;
+    m_last = 0;
+    m_empty = true;
+
+    m_segments.clear();
+    m_buffers.clear();
+    m_headers.clear();
+    m_total_size = 0;
+}
+
+void packet_writer::append_owned(size_t length)
+{
+    size_t needed = m_size + length;
+
+    if (m_buffer.size() < needed)
+    {
+        m_buffer.resize(needed);
+    }
+
+    // Owned bytes following owned bytes go out as one buffer
+    if (!m_segments.empty() && m_segments.back().reference == nullptr)
+    {
+        m_segments.back().length += length;
+    }
+    else
+    {
+        segment_t segment = {nullptr, m_size, length};
+        m_segments.push_back(segment);
+    }
+
+    m_size = needed;
+    m_total_size += length;
+}
+
+void packet_writer::add_header(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, uint32_t payload_length)
+{
+    packet_header_t header;
+    header.magic = PACKET_MAGIC;
+    header.version = PACKET_VERSION;
+    header.type = (uint8_t) type;
+    header.dtype = (uint8_t) dtype;
+    header.flags = 0;
+    header.sequence = m_sequence;
+    header.payload_length = payload_length;
+    header.timestamp_us = m_timestamp_us;
+
+    for (uint32_t i = 0; i < PACKET_MAX_DIMS; ++i)
+    {
+        header.dims[i] = i < num_dims ? dims[i] : 1;
+    }
+
+    header.message = 0;
+    header.dsp_done_us = m_dsp_done_us > m_timestamp_us ? (uint32_t) (m_dsp_done_us - m_timestamp_us) : 0;
+    header.send_us = 0;
+    header.reserved = 0;
+
+    m_last = m_size;
+    m_headers.push_back(m_last);
+    m_empty = false;
+
+    this->append_owned(sizeof(header));
+
+    memcpy(m_buffer.data() + m_last, &header, sizeof(header));
+}
+
+void* packet_writer::add_uninitialised(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, uint32_t payload_length)
+{
+    this->add_header(type, dtype, dims, num_dims, payload_length);
+    this->append_owned(payload_length);
+
+    return m_buffer.data() + m_last + sizeof(packet_header_t);
+}
+
+void packet_writer::add(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, const void* payload, uint32_t payload_length)
+{
+    void* destination = this->add_uninitialised(type, dtype, dims, num_dims, payload_length);
+
+    if (payload_length > 0)
+    {
+        memcpy(destination, payload, payload_length);
+    }
+}
+
+void packet_writer::add_reference(packet_type_t type, packet_dtype_t dtype, const uint32_t* dims, uint32_t num_dims, const void* payload, uint32_t payload_length)
+{
+    this->add_header(type, dtype, dims, num_dims, payload_length);
+
+    if (payload_length > 0)
+    {
+        segment_t segment = {(const uint8_t*) payload, 0, payload_length};
+        m_segments.push_back(segment);
+        m_total_size += payload_length;
+    }
+}
+
+void packet_writer::add_json(packet_type_t type, const std::string& text)
+{
+    uint32_t length = (uint32_t) text.length();
+
+    this->add(type, PACKET_DTYPE_JSON, &length, 1, text.data(), length);
+}
+
+void packet_writer::end()
+{
+    if (m_empty)
+    {
+        return;
+    }
+
+    m_buffer[m_last + offsetof(packet_header_t, flags)] |= PACKET_FLAG_LAST_OF_FRAME;
+
+    // m_buffer doesn't move any more, so the owned runs can be pointed at now
+    m_buffers.clear();
+    for (const segment_t& segment : m_segments)
+    {
+        const uint8_t* data = segment.reference != nullptr ? segment.reference : m_buffer.data() + segment.offset;
+
+        m_buffers.push_back(boost::asio::const_buffer(data, segment.length));
+    }
+}
+
+void packet_writer::stamp(uint32_t message, uint64_t send_time_us)
+{
+    uint32_t send_us = (uint32_t) (send_time_us - m_timestamp_us);
+
+    for (size_t header : m_headers)
+    {
+        memcpy(m_buffer.data() + header + offsetof(packet_header_t, message), &message, sizeof(message));
+        memcpy(m_buffer.data() + header + offsetof(packet_header_t, send_us), &send_us, sizeof(send_us));
+    }
+}
+
+const std::vector<boost::asio::const_buffer>& packet_writer::get_buffers()
+{
+    return m_buffers;
+}
+
+size_t packet_writer::get_size()
+{
+    return m_total_size;
+}
@@ -0,0 +1,615 @@
+#include "packet_sender.hpp"
+#include "packet.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <poll.h>
+#include <string.h>
+
+using boost::asio::ip::tcp;
+
+// How long the destructor lets the queue drain before the connection is cut
+#define PACKET_SENDER_DRAIN_MS 1000
+
+packet_sender::packet_sender(tcp_mode_t tcp_mode, drop_policy_t drop_policy, size_t max_queue_bytes) : m_tcp_mode(tcp_mode),
+                                                                                                        m_drop_policy(drop_policy),
+                                                                                                        m_max_queue_bytes(max_queue_bytes),
+                                                                                                        m_socket(m_io_service),
+                                                                                                        m_timer(m_io_service),
+                                                                                                        m_failed(false),
+                                                                                                        m_connected(false),
+                                                                                                        m_queued_bytes(0),
+                                                                                                        m_sent_bytes(0),
+                                                                                                        m_dropped_bytes(0),
+                                                                                                        m_dropped_messages(0),
+                                                                                                        m_reconnects(0)
+{
+    // Keeps run going while the queue is empty
+    m_work = new boost::asio::io_service::work(m_io_service);
+
+    m_thread = std::thread([this]() { m_io_service.run(); });
+}
+
+packet_sender::~packet_sender()
+{
+    delete m_work;
+
+    // Give what is queued a chance to go out, a stalled receiver doesn't get to block the exit
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(PACKET_SENDER_DRAIN_MS);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (!m_writing)
+            {
+                break;
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    m_io_service.stop();
+    m_thread.join();
+
+    boost::system::error_code error;
+    m_socket.close(error);
+
+    for (message_t& message : m_queue)
+    {
+        delete message.data;
+    }
+
+    for (std::vector<uint8_t>* buffer : m_backlog)
+    {
+        delete buffer;
+    }
+
+    for (std::vector<uint8_t>* buffer : m_free)
+    {
+        delete buffer;
+    }
+}
+
+void packet_sender::configure_socket(unsigned int timeout_ms)
+{
+    // platform-specific switch
+    #if defined _WIN32 || defined WIN32 || defined OS_WIN64 || defined _WIN64 || defined WIN64 || defined WINNT
+        // use windows-specific time
+      int32_t timeout = timeout_ms;
+      setsockopt(m_socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+      setsockopt(m_socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+    #else
+        // assume everything else is posix
+        struct timeval tv;
+        tv.tv_sec  = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(m_socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(m_socket.native_handle(), SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    #endif
+}
+
+bool packet_sender::connect(const std::string& host, uint16_t port, unsigned int timeout_ms, std::string* error)
+{
+    boost::system::error_code ec;
+
+    m_endpoint = tcp::endpoint(boost::asio::ip::address::from_string(host, ec), port);
+    m_timeout_ms = timeout_ms;
+
+    // No point in trying again
+    if (ec)
+    {
+        *error = ec.message();
+        m_error = *error;
+        m_failed = true;
+        return false;
+    }
+
+    // The socket has to exist before options can be set on it
+    m_socket.open(tcp::v4(), ec);
+
+    this->configure_socket(timeout_ms);
+
+    m_socket.connect(m_endpoint, ec);
+
+    if (ec)
+    {
+        *error = ec.message();
+        return false;
+    }
+
+    m_socket.set_option(tcp::no_delay(m_tcp_mode == TCP_MODE_NODELAY), ec);
+
+    m_connected = true;
+
+    return true;
+}
+
+void packet_sender::set_reconnect(size_t backlog_bytes)
+{
+    m_reconnect = true;
+    m_max_backlog_bytes = backlog_bytes;
+}
+
+void packet_sender::start_reconnect()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // The queue belongs to the io thread until it is connected
+        m_writing = true;
+    }
+
+    m_io_service.post(std::bind(&packet_sender::schedule_reconnect, this));
+}
+
+bool packet_sender::accept(tcp::acceptor& acceptor, unsigned int timeout_ms, std::string* error)
+{
+    boost::system::error_code ec;
+
+    acceptor.accept(m_socket, ec);
+
+    if (ec)
+    {
+        *error = ec.message();
+        return false;
+    }
+
+    this->configure_socket(timeout_ms);
+
+    m_socket.set_option(tcp::no_delay(m_tcp_mode == TCP_MODE_NODELAY), ec);
+
+    m_connected = true;
+
+    return true;
+}
+
+bool packet_sender::read_message(std::string* message, uint32_t max_length, unsigned int timeout_ms, std::string* error)
+{
+    // SO_RCVTIMEO only bounds each receive, a peer sending a byte now and then would never time out
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    boost::system::error_code ec;
+    m_socket.non_blocking(true, ec);
+
+    if (ec)
+    {
+        *error = ec.message();
+        return false;
+    }
+
+    uint32_t length = 0;
+    bool ok = this->read_before(&length, 4, deadline, error);
+
+    if (ok && length > max_length)
+    {
+        *error = "message too long";
+        ok = false;
+    }
+
+    if (ok)
+    {
+        message->resize(length);
+        ok = this->read_before(&(*message)[0], length, deadline, error);
+    }
+
+    // The io thread writes with the socket blocking
+    m_socket.non_blocking(false, ec);
+
+    if (ok && ec)
+    {
+        *error = ec.message();
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool packet_sender::read_before(void* data, size_t size, std::chrono::steady_clock::time_point deadline, std::string* error)
+{
+    uint8_t* bytes = (uint8_t*) data;
+    size_t done = 0;
+
+    while (done < size)
+    {
+        boost::system::error_code ec;
+        done += m_socket.read_some(boost::asio::buffer(bytes + done, size - done), ec);
+
+        if (ec == boost::asio::error::would_block)
+        {
+            const long long left_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+            if (left_ms <= 0)
+            {
+                *error = "timed out";
+                return false;
+            }
+
+            struct pollfd readable = {m_socket.native_handle(), POLLIN, 0};
+            poll(&readable, 1, (int) left_ms);
+        }
+        else if (ec)
+        {
+            *error = ec.message();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<uint8_t>* packet_sender::take_buffer()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    return this->take_free_buffer();
+}
+
+std::vector<uint8_t>* packet_sender::take_free_buffer()
+{
+    if (m_free.empty())
+    {
+        return new std::vector<uint8_t>();
+    }
+
+    std::vector<uint8_t>* buffer = m_free.back();
+    m_free.pop_back();
+
+    return buffer;
+}
+
+void packet_sender::send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable)
+{
+    this->queue(buffers, droppable, false);
+}
+
+void packet_sender::send_config(const std::vector<boost::asio::const_buffer>& buffers)
+{
+    if (m_reconnect)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        m_config.resize(boost::asio::buffer_size(buffers));
+        boost::asio::buffer_copy(boost::asio::buffer(m_config), buffers);
+
+        // Goes out first thing once connected again
+        if (!m_connected)
+        {
+            return;
+        }
+    }
+
+    this->queue(buffers, false, true);
+}
+
+void packet_sender::queue(const std::vector<boost::asio::const_buffer>& buffers, bool droppable, bool config)
+{
+    if (m_failed)
+    {
+        return;
+    }
+
+    size_t length = boost::asio::buffer_size(buffers);
+
+    // Copied outside the lock so the io thread isn't held up by it
+    std::vector<uint8_t>* data = this->take_buffer();
+    data->resize(length);
+
+    size_t offset = 0;
+    for (const boost::asio::const_buffer& buffer : buffers)
+    {
+        memcpy(data->data() + offset, buffer.data(), buffer.size());
+        offset += buffer.size();
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (droppable && !this->make_room(length))
+    {
+        m_free.push_back(data);
+
+        m_dropped_bytes += length;
+        ++m_dropped_messages;
+        return;
+    }
+
+    message_t message = {data, droppable, config};
+    m_queue.push_back(message);
+
+    m_queued_bytes += length;
+    if (droppable)
+    {
+        m_droppable_bytes += length;
+    }
+
+    if (!m_writing)
+    {
+        m_writing = true;
+        m_io_service.post(std::bind(&packet_sender::start_write, this));
+    }
+}
+
+void packet_sender::push_front(std::vector<uint8_t>* data, bool droppable, bool config)
+{
+    message_t message = {data, droppable, config};
+    m_queue.push_front(message);
+
+    m_queued_bytes += data->size();
+    if (droppable)
+    {
+        m_droppable_bytes += data->size();
+    }
+}
+
+void packet_sender::drop(std::deque<message_t>::iterator message)
+{
+    size_t length = message->data->size();
+
+    m_droppable_bytes -= length;
+    m_queued_bytes -= length;
+
+    m_dropped_bytes += length;
+    ++m_dropped_messages;
+
+    m_free.push_back(message->data);
+    m_queue.erase(message);
+}
+
+bool packet_sender::make_room(size_t length)
+{
+    if (m_drop_policy == DROP_POLICY_NEWEST)
+    {
+        return m_droppable_bytes + length <= m_max_queue_bytes;
+    }
+
+    // The front message is being written and has to stay where it is
+    size_t first = m_writing ? 1 : 0;
+
+    for (size_t i = first; i < m_queue.size(); )
+    {
+        if (m_drop_policy == DROP_POLICY_OLDEST && m_droppable_bytes + length <= m_max_queue_bytes)
+        {
+            break;
+        }
+
+        if (m_queue[i].droppable)
+        {
+            this->drop(m_queue.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // The newest frame is always kept, even when it alone is over the limit
+    return true;
+}
+
+void packet_sender::start_write()
+{
+    std::vector<uint8_t>* data;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        if (m_queue.empty())
+        {
+            m_writing = false;
+            return;
+        }
+
+        data = m_queue.front().data;
+    }
+
+    // Time spent in the queue counts as sending
+    packet_stamp_send(data->data(), data->size(), packet_time_us());
+
+    this->set_cork(true);
+
+    boost::asio::async_write(m_socket, boost::asio::buffer(*data),
+                             std::bind(&packet_sender::write_done, this, std::placeholders::_1));
+}
+
+void packet_sender::write_done(const boost::system::error_code& error)
+{
+    this->set_cork(false);
+
+    if (error && m_reconnect)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // The front message may not have made it in full, it stays queued and goes out again
+        m_error = error.message();
+        m_connected = false;
+
+        // m_writing stays set, the queue is the io thread's until it is connected again
+        m_io_service.post(std::bind(&packet_sender::schedule_reconnect, this));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        message_t message = m_queue.front();
+        m_queue.pop_front();
+
+        size_t length = message.data->size();
+
+        m_queued_bytes -= length;
+        if (message.droppable)
+        {
+            m_droppable_bytes -= length;
+        }
+
+        if (error)
+        {
+            m_free.push_back(message.data);
+
+            m_error = error.message();
+            m_failed = true;
+
+            // Nothing more goes out on this connection
+            for (message_t& queued : m_queue)
+            {
+                m_free.push_back(queued.data);
+            }
+            m_queue.clear();
+            m_queued_bytes = 0;
+            m_droppable_bytes = 0;
+
+            m_writing = false;
+            return;
+        }
+
+        m_sent_bytes += length;
+
+        // The config is kept on its own
+        if (m_max_backlog_bytes > 0 && !message.config)
+        {
+            m_backlog.push_back(message.data);
+            m_backlog_bytes += length;
+
+            while (m_backlog_bytes > m_max_backlog_bytes)
+            {
+                m_backlog_bytes -= m_backlog.front()->size();
+                m_free.push_back(m_backlog.front());
+                m_backlog.pop_front();
+            }
+        }
+        else
+        {
+            m_free.push_back(message.data);
+        }
+    }
+
+    this->start_write();
+}
+
+void packet_sender::schedule_reconnect()
+{
+    boost::system::error_code ec;
+    m_socket.close(ec);
+
+    m_timer.expires_after(std::chrono::milliseconds(m_backoff_ms));
+    m_timer.async_wait(std::bind(&packet_sender::start_connect, this, std::placeholders::_1));
+
+    m_backoff_ms = std::min(m_backoff_ms * 2, (uint32_t) PACKET_SENDER_RECONNECT_MAX_MS);
+}
+
+void packet_sender::start_connect(const boost::system::error_code& error)
+{
+    if (error)
+    {
+        return;
+    }
+
+    boost::system::error_code ec;
+    m_socket.open(tcp::v4(), ec);
+
+    this->configure_socket(m_timeout_ms);
+
+    m_socket.async_connect(m_endpoint, std::bind(&packet_sender::connect_done, this, std::placeholders::_1));
+
+    // A peer that doesn't answer at all would keep the connect pending for minutes
+    m_timer.expires_after(std::chrono::milliseconds(m_timeout_ms));
+    m_timer.async_wait(std::bind(&packet_sender::connect_timeout, this, std::placeholders::_1));
+}
+
+void packet_sender::connect_timeout(const boost::system::error_code& error)
+{
+    // Cancelled because the connect finished first
+    if (error)
+    {
+        return;
+    }
+
+    // Aborts the connect, connect_done takes it from there
+    boost::system::error_code ec;
+    m_socket.close(ec);
+}
+
+void packet_sender::connect_done(const boost::system::error_code& error)
+{
+    m_timer.cancel();
+
+    if (error || !m_socket.is_open())
+    {
+        this->schedule_reconnect();
+        return;
+    }
+
+    boost::system::error_code ec;
+    m_socket.set_option(tcp::no_delay(m_tcp_mode == TCP_MODE_NODELAY), ec);
+
+    m_backoff_ms = PACKET_SENDER_RECONNECT_MIN_MS;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // Replay oldest first, behind the config and ahead of whatever queued up meanwhile
+        while (!m_backlog.empty())
+        {
+            this->push_front(m_backlog.back(), true, false);
+            m_backlog.pop_back();
+        }
+        m_backlog_bytes = 0;
+
+        if (!m_config.empty())
+        {
+            std::vector<uint8_t>* config = this->take_free_buffer();
+            config->assign(m_config.begin(), m_config.end());
+
+            this->push_front(config, false, true);
+        }
+
+        ++m_reconnects;
+        m_connected = true;
+    }
+
+    this->start_write();
+}
+
+void packet_sender::set_cork(bool cork)
+{
+#ifdef TCP_CORK
+    if (m_tcp_mode == TCP_MODE_CORK)
+    {
+        // Uncorking pushes out the partial last segment
+        int value = cork ? 1 : 0;
+        setsockopt(m_socket.native_handle(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+    }
+#else
+    (void) cork;
+#endif
+}
+
+bool packet_sender::failed()
+{
+    return m_failed;
+}
+
+bool packet_sender::is_connected()
+{
+    return m_connected;
+}
+
+std::string packet_sender::get_error()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    return m_error;
+}
+
+packet_sink_stats_t packet_sender::get_stats()
+{
+    packet_sink_stats_t stats;
+    stats.queued_bytes = m_queued_bytes;
+    stats.sent_bytes = m_sent_bytes;
+    stats.dropped_bytes = m_dropped_bytes;
+    stats.dropped_messages = m_dropped_messages;
+    stats.reconnects = m_reconnects;
+
+    return stats;
+}
@@ -0,0 +1,328 @@
+#include "payload_codec.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+// Quotients from here on are followed by the raw value instead, so one outlier costs a few bytes at most
+#define PAYLOAD_CODEC_RICE_ESCAPE 24
+
+static const char* compression_names[] = {"none", "db16", "db8"};
+
+bool parse_compression(const std::string& name, compression_t* compression)
+{
+    for (uint32_t i = 0; i < sizeof(compression_names) / sizeof(compression_names[0]); ++i)
+    {
+        if (name == compression_names[i])
+        {
+            *compression = (compression_t) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* get_compression_name(compression_t compression)
+{
+    return compression_names[compression];
+}
+
+static size_t get_tables_size(uint32_t num_blocks)
+{
+    // Offsets, steps, then the rice parameters padded to keep the stream 4 byte aligned
+    return num_blocks * 2 * sizeof(float) + (num_blocks + 3) / 4 * 4;
+}
+
+typedef struct
+{
+    std::vector<uint8_t>* out;
+    uint64_t bits;
+    uint32_t num_bits;
+} bit_writer_t;
+
+// n up to 32
+static void put_bits(bit_writer_t* writer, uint32_t value, uint32_t n)
+{
+    writer->bits |= (uint64_t) value << writer->num_bits;
+    writer->num_bits += n;
+
+    while (writer->num_bits >= 8)
+    {
+        writer->out->push_back((uint8_t) writer->bits);
+        writer->bits >>= 8;
+        writer->num_bits -= 8;
+    }
+}
+
+static void flush_bits(bit_writer_t* writer)
+{
+    if (writer->num_bits > 0)
+    {
+        writer->out->push_back((uint8_t) writer->bits);
+    }
+
+    writer->bits = 0;
+    writer->num_bits = 0;
+}
+
+typedef struct
+{
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+    uint64_t bits;
+    uint32_t num_bits;
+} bit_reader_t;
+
+// n up to 32, false once the data runs out
+static bool get_bits(bit_reader_t* reader, uint32_t n, uint32_t* value)
+{
+    while (reader->num_bits < n)
+    {
+        if (reader->offset >= reader->length)
+        {
+            return false;
+        }
+
+        reader->bits |= (uint64_t) reader->data[reader->offset++] << reader->num_bits;
+        reader->num_bits += 8;
+    }
+
+    *value = (uint32_t) (reader->bits & ((1ull << n) - 1));
+    reader->bits >>= n;
+    reader->num_bits -= n;
+
+    return true;
+}
+
+payload_codec::payload_codec(compression_t compression, float max_error_db, float dynamic_range_db) : m_compression(compression),
+                                                                                                       m_max_error_db(max_error_db),
+                                                                                                       m_dynamic_range_db(dynamic_range_db)
+{
+    m_bits = compression == COMPRESSION_DB8 ? 8 : 16;
+}
+
+payload_codec::~payload_codec()
+{
+    //dtor
+}
+
+const std::vector<uint8_t>& payload_codec::compress(const float* values, uint32_t count, bool in_db)
+{
+    const uint32_t max_level = (1u << m_bits) - 1;
+    const uint32_t num_blocks = (count + PAYLOAD_CODEC_BLOCK_SIZE - 1) / PAYLOAD_CODEC_BLOCK_SIZE;
+
+    m_db.resize(count);
+    m_residuals.resize(PAYLOAD_CODEC_BLOCK_SIZE);
+
+    float peak = -INFINITY;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Small offset keeps empty bins finite, they end up on the floor anyway
+        float db = in_db ? values[i] : 10.0f * log10f(values[i] + 1e-20f);
+
+        m_db[i] = db;
+        peak = std::max(peak, db);
+    }
+
+    float floor_db = count > 0 ? peak - m_dynamic_range_db : 0.0f;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_db[i] = std::max(m_db[i], floor_db);
+    }
+
+    payload_codec_header_t header;
+    header.flags = in_db ? PAYLOAD_CODEC_FLAG_DB : 0;
+    header.bits = (uint8_t) m_bits;
+    header.block_size = PAYLOAD_CODEC_BLOCK_SIZE;
+    header.count = count;
+    header.max_error_db = this->get_error_bound_db();
+    header.floor_db = floor_db;
+
+    size_t tables_size = get_tables_size(num_blocks);
+
+    m_output.assign(sizeof(header) + tables_size, 0);
+    memcpy(m_output.data(), &header, sizeof(header));
+
+    // The tables are filled in as the blocks go, m_output grows behind them
+    size_t offsets_at = sizeof(header);
+    size_t steps_at = offsets_at + num_blocks * sizeof(float);
+    size_t rice_at = steps_at + num_blocks * sizeof(float);
+
+    bit_writer_t writer = {&m_output, 0, 0};
+
+    for (uint32_t block = 0; block < num_blocks; ++block)
+    {
+        const float* db = m_db.data() + block * PAYLOAD_CODEC_BLOCK_SIZE;
+        uint32_t size = std::min((uint32_t) PAYLOAD_CODEC_BLOCK_SIZE, count - block * PAYLOAD_CODEC_BLOCK_SIZE);
+
+        float low = db[0];
+        float high = db[0];
+        for (uint32_t i = 1; i < size; ++i)
+        {
+            low = std::min(low, db[i]);
+            high = std::max(high, db[i]);
+        }
+
+        // As fine as the error bound asks for, coarser only when the levels don't reach that far
+        float step = std::max(2.0f * m_max_error_db, (high - low) / max_level);
+        float inverse = 1.0f / step;
+
+        int32_t previous = 0;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            int32_t level = (int32_t) std::min((uint32_t) lrintf((db[i] - low) * inverse), max_level);
+            int32_t delta = level - previous;
+
+            m_residuals[i] = ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+            sum += m_residuals[i];
+            previous = level;
+        }
+
+        // Rice parameter close to log2 of the mean residual is within a bit of the best one
+        uint32_t rice = 0;
+        while (rice < m_bits && ((uint64_t) size << (rice + 1)) <= sum)
+        {
+            ++rice;
+        }
+
+        memcpy(m_output.data() + offsets_at + block * sizeof(float), &low, sizeof(float));
+        memcpy(m_output.data() + steps_at + block * sizeof(float), &step, sizeof(float));
+        m_output[rice_at + block] = (uint8_t) rice;
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            uint32_t quotient = m_residuals[i] >> rice;
+
+            if (quotient < PAYLOAD_CODEC_RICE_ESCAPE)
+            {
+                // quotient ones, then a zero
+                put_bits(&writer, (1u << quotient) - 1, quotient + 1);
+                put_bits(&writer, m_residuals[i] & ((1u << rice) - 1), rice);
+            }
+            else
+            {
+                put_bits(&writer, (1u << PAYLOAD_CODEC_RICE_ESCAPE) - 1, PAYLOAD_CODEC_RICE_ESCAPE);
+                put_bits(&writer, m_residuals[i], m_bits + 1);
+            }
+        }
+    }
+
+    flush_bits(&writer);
+
+    return m_output;
+}
+
+bool payload_codec::decompress(const uint8_t* data, size_t length, std::vector<float>* values)
+{
+    payload_codec_header_t header;
+    if (length < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if ((header.bits != 8 && header.bits != 16) || header.block_size == 0)
+    {
+        return false;
+    }
+
+    uint32_t num_blocks = (uint32_t) (((uint64_t) header.count + header.block_size - 1) / header.block_size);
+    size_t tables_size = get_tables_size(num_blocks);
+
+    if (length < sizeof(header) + tables_size)
+    {
+        return false;
+    }
+
+    const uint8_t* offsets = data + sizeof(header);
+    const uint8_t* steps = offsets + num_blocks * sizeof(float);
+    const uint8_t* rices = steps + num_blocks * sizeof(float);
+
+    bit_reader_t reader = {data, length, sizeof(header) + tables_size, 0, 0};
+
+    values->resize(header.count);
+
+    for (uint32_t block = 0; block < num_blocks; ++block)
+    {
+        float low;
+        float step;
+        memcpy(&low, offsets + block * sizeof(float), sizeof(float));
+        memcpy(&step, steps + block * sizeof(float), sizeof(float));
+        uint32_t rice = rices[block];
+
+        if (rice > header.bits)
+        {
+            return false;
+        }
+
+        uint32_t first = block * header.block_size;
+        uint32_t size = std::min((uint32_t) header.block_size, header.count - first);
+
+        int32_t level = 0;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            uint32_t quotient = 0;
+            uint32_t bit = 1;
+            while (quotient < PAYLOAD_CODEC_RICE_ESCAPE)
+            {
+                if (!get_bits(&reader, 1, &bit))
+                {
+                    return false;
+                }
+                if (bit == 0)
+                {
+                    break;
+                }
+                ++quotient;
+            }
+
+            uint32_t residual;
+            if (quotient < PAYLOAD_CODEC_RICE_ESCAPE)
+            {
+                uint32_t remainder = 0;
+                if (rice > 0 && !get_bits(&reader, rice, &remainder))
+                {
+                    return false;
+                }
+                residual = (quotient << rice) | remainder;
+            }
+            else if (!get_bits(&reader, header.bits + 1, &residual))
+            {
+                return false;
+            }
+
+            level += (int32_t) (residual >> 1) ^ -(int32_t) (residual & 1);
+
+            float db = low + level * step;
+            (*values)[first + i] = (header.flags & PAYLOAD_CODEC_FLAG_DB) ? db : powf(10.0f, db / 10.0f);
+        }
+    }
+
+    return true;
+}
+
+compression_t payload_codec::get_compression()
+{
+    return m_compression;
+}
+
+float payload_codec::get_error_bound_db()
+{
+    return std::max(m_max_error_db, m_dynamic_range_db / ((1u << m_bits) - 1) / 2.0f);
+}
+
+json payload_codec::create_json()
+{
+    json data;
+    data["mode"] = get_compression_name(m_compression);
+    data["max_error_db"] = this->get_error_bound_db();
+    data["dynamic_range_db"] = m_dynamic_range_db;
+    data["block_size"] = PAYLOAD_CODEC_BLOCK_SIZE;
+
+    return data;
+}
@@ -0,0 +1,265 @@
+#include "presence.hpp"
+
+#include <iostream>
+
+presence::presence(radar_config* radar_config, std::shared_ptr<const processing_profile> profile) : m_radar_config(radar_config),
+                                                                                                      m_profile(profile)
+{
+    this->create_handles();
+}
+
+presence::~presence()
+{
+    this->destroy_handles();
+}
+
+void presence::update_config()
+{
+    this->destroy_handles();
+    this->create_handles();
+}
+
+bool presence::failed()
+{
+    return !m_error.empty();
+}
+
+std::string presence::get_error()
+{
+    return m_error;
+}
+
+void presence::create_handles()
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    m_error.clear();
+
+    ifx_Error_t err = ifx_mti_create(metrics->m_mti_weight, metrics->m_range_gate_num_bins, &m_mti_handle);
+    if (err != IFX_OK)
+    {
+        m_error = "can't create the presence MTI, SDK error " + std::to_string(err);
+        m_mti_handle = nullptr;
+    }
+
+    err = ifx_vector_create_r(metrics->m_range_gate_num_bins, &m_mti_result);
+    if (err != IFX_OK)
+    {
+        m_error = "can't create the presence spectrum, SDK error " + std::to_string(err);
+        m_mti_result.data = nullptr;
+        m_mti_result.length = 0;
+    }
+
+    this->create_peak_search(&m_presence_search, metrics->m_threshold_factor_presence_peak);
+    this->create_peak_search(&m_absence_search, metrics->m_threshold_factor_absence_peak);
+
+    if (this->failed())
+    {
+        std::cerr << "Presence detector disabled: " << m_error << std::endl;
+    }
+}
+
+void presence::destroy_handles()
+{
+    this->destroy_peak_search(&m_presence_search);
+    this->destroy_peak_search(&m_absence_search);
+
+    if (m_mti_result.data != nullptr)
+    {
+        ifx_vector_destroy_r(&m_mti_result);
+    }
+
+    if (m_mti_handle != nullptr)
+    {
+        ifx_mti_destroy(m_mti_handle);
+    }
+}
+
+void presence::create_peak_search(peak_search_t* search, float threshold_factor)
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    // The spectrum is already gated to the detection zone, so the whole of it is searched
+    ifx_Peak_Search_Config_t config =
+    {
+        .value_per_bin = metrics->m_value_per_bin,
+        .search_zone_start = 0,
+        .search_zone_end = (metrics->m_range_gate_num_bins - 1) * metrics->m_value_per_bin,
+        .threshold_factor = threshold_factor,
+        .threshold_offset = 0,
+        .max_num_peaks = PRESENCE_MAX_PEAKS
+    };
+
+    ifx_Error_t err = ifx_peak_search_create(&config, &(search->peak_search_handle));
+    if (err != IFX_OK)
+    {
+        m_error = "can't create the presence peak search, SDK error " + std::to_string(err);
+        search->peak_search_handle = nullptr;
+    }
+
+    search->peak_search_result.peak_count = 0;
+    search->peak_search_result.index = new uint32_t[PRESENCE_MAX_PEAKS];
+}
+
+void presence::destroy_peak_search(peak_search_t* search)
+{
+    if (search->peak_search_handle != nullptr)
+    {
+        ifx_peak_search_destroy(search->peak_search_handle);
+    }
+
+    delete[] search->peak_search_result.index;
+}
+
+bool presence::fine_absence_check()
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    uint32_t zone_start = 0;
+    uint32_t zone_end = m_mti_result.length - 1;
+
+    float mean = 0.0f;
+    for (uint32_t i = zone_start; i <= zone_end; ++i)
+    {
+        mean += m_mti_result.data[i];
+    }
+    mean /= (zone_end - zone_start + 1);
+
+    // Only look around where the target was last seen
+    uint32_t start = m_target_bin > zone_start + metrics->m_range_hysteresis ? m_target_bin - metrics->m_range_hysteresis : zone_start;
+    uint32_t end = m_target_bin + metrics->m_range_hysteresis < zone_end ? m_target_bin + metrics->m_range_hysteresis : zone_end;
+
+    for (uint32_t i = start; i <= end; ++i)
+    {
+        if (m_mti_result.data[i] > metrics->m_threshold_factor_absence_fine_peak * mean)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+presence_state_t presence::update(ifx_Vector_R_t* range_spectrum)
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    m_state_changed = false;
+    m_motion = false;
+
+    // Without its handles the detector has nothing to go on, the state stays where it is
+    if (this->failed())
+    {
+        return m_state;
+    }
+
+    for (uint32_t i = 0; i < m_mti_result.length && i < range_spectrum->length; ++i)
+    {
+        m_mti_result.data[i] = range_spectrum->data[i];
+    }
+
+    if (ifx_mti_run(m_mti_handle, &m_mti_result) != IFX_OK)
+    {
+        return m_state;
+    }
+
+    if (m_state == PRESENCE_STATE_ABSENT)
+    {
+        ifx_peak_search_run(m_presence_search.peak_search_handle, &m_mti_result, &(m_presence_search.peak_search_result));
+
+        m_motion = m_presence_search.peak_search_result.peak_count > 0;
+
+        if (m_motion)
+        {
+            m_target_bin = m_presence_search.peak_search_result.index[0];
+            m_pending_count += 1;
+        }
+        else
+        {
+            m_pending_count = 0;
+        }
+
+        if (m_pending_count >= metrics->m_presence_confirm_count)
+        {
+            m_state = PRESENCE_STATE_PRESENT;
+            m_state_changed = true;
+            m_pending_count = 0;
+        }
+    }
+    else
+    {
+        ifx_peak_search_run(m_absence_search.peak_search_handle, &m_mti_result, &(m_absence_search.peak_search_result));
+
+        m_motion = m_absence_search.peak_search_result.peak_count > 0;
+
+        if (m_motion)
+        {
+            m_target_bin = m_absence_search.peak_search_result.index[0];
+            m_pending_count = 0;
+        }
+        else if (this->fine_absence_check())
+        {
+            m_pending_count = 0;
+        }
+        else
+        {
+            m_pending_count += 1;
+        }
+
+        if (m_pending_count >= metrics->m_absence_confirm_count)
+        {
+            m_state = PRESENCE_STATE_ABSENT;
+            m_state_changed = true;
+            m_pending_count = 0;
+        }
+    }
+
+    return m_state;
+}
+
+presence_state_t presence::get_state()
+{
+    return m_state;
+}
+
+bool presence::state_changed()
+{
+    return m_state_changed;
+}
+
+bool presence::motion_detected()
+{
+    return m_motion;
+}
+
+float presence::get_target_range()
+{
+    return m_profile->get_range(m_target_bin);
+}
+
+uint32_t presence::get_target_bin()
+{
+    return m_target_bin;
+}
+
+json presence::create_json()
+{
+    json data;
+
+    data["present"] = m_state == PRESENCE_STATE_PRESENT;
+    data["range"] = this->get_target_range();
+
+    return data;
+}
+
+void presence::write_json(json_writer* writer)
+{
+    writer->begin_object();
+
+    writer->key("present");
+    writer->value(m_state == PRESENCE_STATE_PRESENT);
+    writer->key("range");
+    writer->value(this->get_target_range());
+
+    writer->end_object();
+}
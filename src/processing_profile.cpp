@@ -0,0 +1,202 @@
+#include "processing_profile.hpp"
+
+#include "ifxRadar_Vector.h"
+#include "ifxRadar_Window.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+processing_profile::processing_profile(const device_metrics_t* metrics, const ifx_Device_Config_t* device_config)
+{
+    m_gate_start = metrics->m_range_gate_start_bin;
+    m_gate_num_bins = metrics->m_range_gate_num_bins;
+
+    m_range_axis = new float[m_gate_num_bins];
+    for (uint32_t i = 0; i < m_gate_num_bins; ++i)
+    {
+        m_range_axis[i] = (m_gate_start + i) * metrics->m_value_per_bin;
+    }
+
+    uint32_t gate_end = m_gate_start + m_gate_num_bins - 1;
+
+    m_bin_of_interest = (uint32_t) (PROCESSING_PROFILE_RANGE_OF_INTEREST_M / metrics->m_value_per_bin + 0.5f);
+    m_bin_of_interest = std::max(m_gate_start, std::min(m_bin_of_interest, gate_end));
+
+    m_slow_time_min_bin = m_bin_of_interest > m_gate_start + PROCESSING_PROFILE_SLOW_TIME_HALF_WIDTH ? m_bin_of_interest - PROCESSING_PROFILE_SLOW_TIME_HALF_WIDTH : m_gate_start;
+    m_slow_time_max_bin = std::min(m_bin_of_interest + PROCESSING_PROFILE_SLOW_TIME_HALF_WIDTH, gate_end);
+
+    m_num_chirps = device_config->num_chirps_per_frame;
+    m_num_doppler_bins = m_num_chirps * 2;
+
+    // Shifted spectrum, the middle bin is zero speed
+    float speed_per_bin = 2.0f * metrics->m_maximum_speed / m_num_doppler_bins;
+    m_speed_axis = new float[m_num_doppler_bins];
+    for (uint32_t i = 0; i < m_num_doppler_bins; ++i)
+    {
+        m_speed_axis[i] = ((float) i - (float) (m_num_doppler_bins / 2)) * speed_per_bin;
+    }
+
+    m_doppler_window = new float[m_num_chirps];
+
+    if (!create_doppler_window(metrics, m_num_chirps, m_doppler_window, &m_error))
+    {
+        std::fill(m_doppler_window, m_doppler_window + m_num_chirps, 1.0f);
+    }
+
+    for (uint32_t k = 0; k < RANGE_ANGLE_NUM_BINS; ++k)
+    {
+        float sine = -1.0f + 2.0f * k / RANGE_ANGLE_NUM_BINS;
+
+        m_steering_real[k] = cosf((float) M_PI * sine);
+        m_steering_imag[k] = sinf((float) M_PI * sine);
+    }
+
+    // Only planned here, the buffers are never run through it
+    fftw_complex* in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * NUM_FFT_POINTS);
+    fftw_complex* out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * NUM_FFT_POINTS);
+
+    m_slow_time_plan = fftw_plan_dft_1d(NUM_FFT_POINTS, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
+
+    fftw_free(in);
+    fftw_free(out);
+}
+
+processing_profile::~processing_profile()
+{
+    fftw_destroy_plan(m_slow_time_plan);
+
+    delete[] m_range_axis;
+    delete[] m_speed_axis;
+    delete[] m_doppler_window;
+}
+
+bool processing_profile::create_doppler_window(const device_metrics_t* metrics, uint32_t num_chirps, float* window, std::string* error)
+{
+    // Same window type as the range transform
+    ifx_Window_Config_t window_config =
+    {
+        .type = metrics->m_range_fft_window_type,
+        .size = num_chirps,
+        .at_dB = metrics->m_range_fft_window_alpha
+    };
+
+    ifx_Vector_R_t coefficients;
+
+    ifx_Error_t err = ifx_vector_create_r(num_chirps, &coefficients);
+    if (err != IFX_OK)
+    {
+        *error = "can't allocate the Doppler window, SDK error " + std::to_string(err);
+        return false;
+    }
+
+    err = ifx_window_init(&window_config, &coefficients);
+    if (err != IFX_OK)
+    {
+        *error = "can't build the Doppler window, SDK error " + std::to_string(err);
+        ifx_vector_destroy_r(&coefficients);
+        return false;
+    }
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < num_chirps; ++i)
+    {
+        sum += coefficients.data[i];
+    }
+
+    float scale = sum != 0.0f ? num_chirps / sum : 1.0f;
+
+    for (uint32_t i = 0; i < num_chirps; ++i)
+    {
+        window[i] = coefficients.data[i] * scale;
+    }
+
+    ifx_vector_destroy_r(&coefficients);
+
+    return true;
+}
+
+bool processing_profile::failed() const
+{
+    return !m_error.empty();
+}
+
+std::string processing_profile::get_error() const
+{
+    return m_error;
+}
+
+uint32_t processing_profile::get_gate_start() const
+{
+    return m_gate_start;
+}
+
+uint32_t processing_profile::get_gate_num_bins() const
+{
+    return m_gate_num_bins;
+}
+
+float processing_profile::get_range(uint32_t gated_bin) const
+{
+    return m_range_axis[gated_bin];
+}
+
+const float* processing_profile::get_range_axis() const
+{
+    return m_range_axis;
+}
+
+uint32_t processing_profile::get_bin_of_interest() const
+{
+    return m_bin_of_interest;
+}
+
+uint32_t processing_profile::get_slow_time_min_bin() const
+{
+    return m_slow_time_min_bin;
+}
+
+uint32_t processing_profile::get_slow_time_max_bin() const
+{
+    return m_slow_time_max_bin;
+}
+
+uint32_t processing_profile::get_num_chirps() const
+{
+    return m_num_chirps;
+}
+
+uint32_t processing_profile::get_num_doppler_bins() const
+{
+    return m_num_doppler_bins;
+}
+
+float processing_profile::get_speed(uint32_t doppler_bin) const
+{
+    return m_speed_axis[doppler_bin];
+}
+
+const float* processing_profile::get_speed_axis() const
+{
+    return m_speed_axis;
+}
+
+const float* processing_profile::get_doppler_window() const
+{
+    return m_doppler_window;
+}
+
+const float* processing_profile::get_steering_real() const
+{
+    return m_steering_real;
+}
+
+const float* processing_profile::get_steering_imag() const
+{
+    return m_steering_imag;
+}
+
+fftw_plan processing_profile::get_slow_time_plan() const
+{
+    return m_slow_time_plan;
+}
@@ -1,4 +1,8 @@
 #include "radar_config.hpp"
+#include "processing_profile.hpp"
+
+#include <fstream>
+#include <vector>
 
 radar_config::radar_config()
 {
@@ -30,6 +34,16 @@ radar_config::radar_config()
 
     m_device_metrics.m_threshold_factor_absence_fine_peak = 1.5f;
 
+    m_device_metrics.m_minimum_detection_range = 0.2f;
+
+    m_device_metrics.m_maximum_detection_range = 2.0f;
+
+    m_device_metrics.m_range_hysteresis = 10;
+
+    m_device_metrics.m_presence_confirm_count = 5;
+
+    m_device_metrics.m_absence_confirm_count = 4;
+
     compute_metrics();
 }
 
@@ -145,6 +159,256 @@ void radar_config::compute_metrics()
     };
 
     m_device_metrics.m_value_per_bin = (float) (300000.0f / ((m_device_config.upper_frequency_kHz - m_device_config.lower_frequency_kHz) * 2 * (m_device_metrics.m_range_fft_size / m_device_config.num_samples_per_chirp )));
+
+    /*
+     * Nothing outside the detection zone is ever looked at, so only those bins of the range
+     * transform are handed on. The gate always lies inside the first half of the spectrum.
+     */
+    uint32_t half_bins = m_device_metrics.m_range_fft_size / 2;
+    uint32_t gate_start = (uint32_t) (m_device_metrics.m_minimum_detection_range / m_device_metrics.m_value_per_bin);
+    uint32_t gate_end = (uint32_t) (m_device_metrics.m_maximum_detection_range / m_device_metrics.m_value_per_bin + 0.999f);
+
+    if (gate_end >= half_bins)
+    {
+        gate_end = half_bins - 1;
+    }
+    if (gate_start > gate_end)
+    {
+        gate_start = gate_end;
+    }
+
+    m_device_metrics.m_range_gate_start_bin = gate_start;
+    m_device_metrics.m_range_gate_num_bins = gate_end - gate_start + 1;
+}
+
+void radar_config::set_frame_rate(float frame_rate)
+{
+    m_device_metrics.m_frame_rate = frame_rate;
+
+    compute_metrics();
+}
+
+bool radar_config::load_file(const std::string& path, std::string* error)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+    {
+        *error = "can't open " + path;
+        return false;
+    }
+
+    json config = json::parse(file, nullptr, false);
+
+    if (config.is_discarded() || !config.is_object())
+    {
+        *error = path + " is not a json object";
+        return false;
+    }
+
+    radar_config candidate(*this);
+    device_metrics_t* metrics = &candidate.m_device_metrics;
+
+    bool types_valid = true;
+
+    auto read = [&config, &types_valid, error](const char* key, float* value)
+    {
+        if (!config.contains(key))
+        {
+            return false;
+        }
+
+        if (!config[key].is_number())
+        {
+            *error = std::string(key) + " is not a number";
+            types_valid = false;
+            return false;
+        }
+
+        *value = config[key].get<float>();
+        return true;
+    };
+
+    float value;
+
+    read("IFX_RANGE_RESOLUTION_M", &metrics->m_range_resolution);
+    read("IFX_MAXIMUM_RANGE_M", &metrics->m_maximum_range);
+    read("IFX_SPEED_RESOLUTION_M_S", &metrics->m_speed_resolution);
+    read("IFX_MAXIMUM_SPEED_M_S", &metrics->m_maximum_speed);
+    read("IFX_FRAME_RATE_HZ", &metrics->m_frame_rate);
+
+    if (read("IFX_BGT_TX_POWER", &value))
+    {
+        metrics->m_bgt_tx_power = (uint8_t) value;
+    }
+
+    // The file holds the number of antennas, the device wants a mask
+    if (read("IFX_RX_ANTENNA_NUMBER", &value))
+    {
+        if (value < 1.0f || value > 3.0f)
+        {
+            *error = "IFX_RX_ANTENNA_NUMBER must be between 1 and 3";
+            return false;
+        }
+        metrics->m_rx_antenna_number = (uint8_t) ((1 << (uint32_t) value) - 1);
+    }
+
+    if (read("IFX_IF_GAIN_DB", &value))
+    {
+        metrics->m_if_gain_db = (int8_t) value;
+    }
+
+    read("IFX_MTI_WEIGHT", &metrics->m_mti_weight);
+    read("IFX_MINIMUM_DETECTION_RANGE_M", &metrics->m_minimum_detection_range);
+    read("IFX_MAXIMUM_DETECTION_RANGE_M", &metrics->m_maximum_detection_range);
+
+    if (read("IFX_RANGE_HYSTERESIS", &value))
+    {
+        metrics->m_range_hysteresis = (uint32_t) value;
+    }
+
+    if (read("IFX_ABSENCE_CONFIRM_COUNT", &value))
+    {
+        metrics->m_absence_confirm_count = (uint32_t) value;
+    }
+
+    if (read("IFX_PRESENCE_CONFIRM_COUNT", &value))
+    {
+        metrics->m_presence_confirm_count = (uint32_t) value;
+    }
+
+    if (read("IFX_RANGE_SPECTRUM_MODE", &value))
+    {
+        if (value < RANGE_SPECTRUM_MODE_SINGLE_CHIRP || value > RANGE_SPECTRUM_MODE_MAX_BIN)
+        {
+            *error = "IFX_RANGE_SPECTRUM_MODE is out of range";
+            return false;
+        }
+        metrics->m_range_spectrum_mode = (ifx_Range_Spectrum_Mode_t) value;
+    }
+
+    read("IFX_THRESHOLD_FACTOR_PRESENCE_PEAK", &metrics->m_threshold_factor_presence_peak);
+    read("IFX_THRESHOLD_FACTOR_ABSENCE_PEAK", &metrics->m_threshold_factor_absence_peak);
+    read("IFX_THRESHOLD_FACTOR_ABSENCE_FINE_PEAK", &metrics->m_threshold_factor_absence_fine_peak);
+
+    if (!types_valid)
+    {
+        return false;
+    }
+
+    if (!candidate.validate(error))
+    {
+        return false;
+    }
+
+    candidate.compute_metrics();
+
+    *this = candidate;
+
+    return true;
+}
+
+bool radar_config::validate(std::string* error)
+{
+    device_metrics_t* metrics = &m_device_metrics;
+
+    if (metrics->m_range_resolution <= 0.0f || metrics->m_maximum_range <= metrics->m_range_resolution)
+    {
+        *error = "range resolution must be positive and below the maximum range";
+        return false;
+    }
+
+    if (metrics->m_speed_resolution <= 0.0f || metrics->m_maximum_speed <= metrics->m_speed_resolution)
+    {
+        *error = "speed resolution must be positive and below the maximum speed";
+        return false;
+    }
+
+    if (!(metrics->m_frame_rate >= RADAR_CONFIG_MIN_FRAME_RATE))
+    {
+        *error = "frame rate must be at least " + std::to_string(RADAR_CONFIG_MIN_FRAME_RATE) + " Hz";
+        return false;
+    }
+
+    if (metrics->m_bgt_tx_power > 31)
+    {
+        *error = "tx power must be between 0 and 31";
+        return false;
+    }
+
+    if (metrics->m_mti_weight < 0.0f || metrics->m_mti_weight > 1.0f)
+    {
+        *error = "mti weight must be between 0 and 1";
+        return false;
+    }
+
+    if (metrics->m_minimum_detection_range < 0.0f ||
+        metrics->m_minimum_detection_range >= metrics->m_maximum_detection_range ||
+        metrics->m_maximum_detection_range > metrics->m_maximum_range)
+    {
+        *error = "detection range must lie inside the maximum range";
+        return false;
+    }
+
+    if (metrics->m_presence_confirm_count == 0 || metrics->m_absence_confirm_count == 0)
+    {
+        *error = "confirm counts must be at least one";
+        return false;
+    }
+
+    if (metrics->m_threshold_factor_presence_peak <= 0.0f ||
+        metrics->m_threshold_factor_absence_peak <= 0.0f ||
+        metrics->m_threshold_factor_absence_fine_peak <= 0.0f)
+    {
+        *error = "threshold factors must be positive";
+        return false;
+    }
+
+    // Both transforms are limited to the FFT sizes of the SDK, the Doppler one is zero padded twice
+    radar_config computed(*this);
+    computed.compute_metrics();
+
+    if (computed.m_device_config.num_samples_per_chirp < FFT_SIZE_16 ||
+        computed.m_device_config.num_samples_per_chirp > FFT_SIZE_1024)
+    {
+        *error = "samples per chirp must be between 16 and 1024";
+        return false;
+    }
+
+    if (computed.m_device_config.num_chirps_per_frame < FFT_SIZE_16 / 2 ||
+        computed.m_device_config.num_chirps_per_frame > FFT_SIZE_1024 / 2)
+    {
+        *error = "chirps per frame must be between 8 and 512";
+        return false;
+    }
+
+    // The window type and attenuation are only checked by the SDK
+    std::vector<float> window(computed.m_device_config.num_chirps_per_frame);
+    if (!processing_profile::create_doppler_window(&computed.m_device_metrics, computed.m_device_config.num_chirps_per_frame, window.data(), error))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool radar_config::same_dimensions(radar_config* other)
+{
+    return m_device_config.num_samples_per_chirp == other->m_device_config.num_samples_per_chirp &&
+           m_device_config.num_chirps_per_frame == other->m_device_config.num_chirps_per_frame &&
+           m_device_config.rx_antenna_mask == other->m_device_config.rx_antenna_mask &&
+           m_device_metrics.m_range_fft_size == other->m_device_metrics.m_range_fft_size &&
+           m_device_metrics.m_value_per_bin == other->m_device_metrics.m_value_per_bin &&
+           m_device_metrics.m_maximum_speed == other->m_device_metrics.m_maximum_speed &&
+           m_device_metrics.m_range_fft_window_type == other->m_device_metrics.m_range_fft_window_type &&
+           m_device_metrics.m_range_fft_window_alpha == other->m_device_metrics.m_range_fft_window_alpha &&
+           m_device_metrics.m_range_gate_start_bin == other->m_device_metrics.m_range_gate_start_bin &&
+           m_device_metrics.m_range_gate_num_bins == other->m_device_metrics.m_range_gate_num_bins;
+}
+
+std::shared_ptr<const processing_profile> radar_config::create_processing_profile()
+{
+    return std::shared_ptr<const processing_profile>(new processing_profile(&m_device_metrics, &m_device_config));
 }
 
 json radar_config::create_json()
@@ -170,6 +434,9 @@ json radar_config::create_json()
     config["range_fft_size"]    = m_device_metrics.m_range_fft_size;
     config["num_samples_per_chirp"]    = m_device_config.num_samples_per_chirp;
 
+    config["range_gate_start_bin"] = m_device_metrics.m_range_gate_start_bin;
+    config["range_gate_num_bins"]  = m_device_metrics.m_range_gate_num_bins;
+
     return config;
 }
 
@@ -2,24 +2,100 @@
 
 radar_control::radar_control(radar_config* rc) : m_radar_config(rc)
 {
+    m_frame.num_rx = 0;
+    m_frame.rx_data = nullptr;
+
     ifx_Error_t ret = ifx_device_create(m_radar_config->get_device_config(), &m_device_handle);
 
+    if (ret != IFX_OK)
+    {
+        m_device_handle = nullptr;
+        return;
+    }
+
     // Allow SDK to create a frame
     ret = ifx_device_create_frame_from_device_handle(m_device_handle, &m_frame);
 
+    if (ret != IFX_OK)
+    {
+        m_frame.num_rx = 0;
+        m_frame.rx_data = nullptr;
+    }
 }
 
 radar_control::~radar_control()
 {
-    ifx_device_destroy(m_device_handle);
-    ifx_device_destroy_frame(&m_frame);
+    if (m_device_handle != nullptr)
+    {
+        ifx_device_destroy(m_device_handle);
+    }
+
+    if (m_frame.rx_data != nullptr)
+    {
+        ifx_device_destroy_frame(&m_frame);
+    }
 }
 
 ifx_Error_t radar_control::pull_frame()
 {
+    // A failed reconfigure leaves nothing to acquire with
+    if (m_device_handle == nullptr || m_frame.rx_data == nullptr)
+    {
+        return IFX_ERROR_NO_DEVICE;
+    }
+
     return ifx_device_get_next_frame(m_device_handle, &m_frame);
 }
 
+ifx_Error_t radar_control::reconfigure()
+{
+    ifx_Device_Config_t* config = m_radar_config->get_device_config();
+
+    // The SDK can't change a running acquisition, so the device is opened again. It can't be opened
+    // twice either, so the old handle goes first and stays null when the new one can't be had.
+    if (m_device_handle != nullptr)
+    {
+        ifx_device_destroy(m_device_handle);
+        m_device_handle = nullptr;
+    }
+
+    ifx_Device_Handle_t device_handle;
+    ifx_Error_t ret = ifx_device_create(config, &device_handle);
+
+    if (ret != IFX_OK)
+    {
+        return ret;
+    }
+
+    m_device_handle = device_handle;
+
+    uint8_t num_rx = 0;
+    for (uint8_t mask = config->rx_antenna_mask; mask != 0; mask >>= 1)
+    {
+        num_rx += mask & 1;
+    }
+
+    if (m_frame.rx_data == nullptr || m_frame.num_rx != num_rx ||
+        m_frame.rx_data[0].rows != config->num_chirps_per_frame ||
+        m_frame.rx_data[0].columns != config->num_samples_per_chirp)
+    {
+        if (m_frame.rx_data != nullptr)
+        {
+            ifx_device_destroy_frame(&m_frame);
+        }
+
+        ret = ifx_device_create_frame_from_device_handle(m_device_handle, &m_frame);
+
+        if (ret != IFX_OK)
+        {
+            m_frame.num_rx = 0;
+            m_frame.rx_data = nullptr;
+        }
+    }
+
+    return ret;
+}
+
 ifx_Frame_t radar_control::get_frame()
 {
     return m_frame;
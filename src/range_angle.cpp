@@ -0,0 +1,107 @@
+#include "range_angle.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#define REAL 0
+#define IMAG 1
+
+range_angle::range_angle(radar_config* radar_config, std::shared_ptr<const processing_profile> profile) : m_radar_config(radar_config),
+                                                                                                            m_profile(profile),
+                                                                                                            m_num_range_bins(profile->get_gate_num_bins())
+{
+    m_a_real = new float[m_num_range_bins];
+    m_a_imag = new float[m_num_range_bins];
+    m_b_real = new float[m_num_range_bins];
+    m_b_imag = new float[m_num_range_bins];
+
+    m_map = new float[RANGE_ANGLE_NUM_BINS * m_num_range_bins];
+}
+
+range_angle::~range_angle()
+{
+    delete[] m_a_real;
+    delete[] m_a_imag;
+    delete[] m_b_real;
+    delete[] m_b_imag;
+
+    delete[] m_map;
+}
+
+void range_angle::run(const ifx_Matrix_C_t* a, const ifx_Matrix_C_t* b)
+{
+    const uint32_t num_range_bins = m_num_range_bins;
+
+    const float* steering_real = m_profile->get_steering_real();
+    const float* steering_imag = m_profile->get_steering_imag();
+
+    memset(m_map, 0, RANGE_ANGLE_NUM_BINS * num_range_bins * sizeof(float));
+
+    for (uint32_t chirp = 0; chirp < a->rows; ++chirp)
+    {
+        const ifx_Complex_t* row_a = a->data + chirp * a->columns;
+        const ifx_Complex_t* row_b = b->data + chirp * b->columns;
+
+        for (uint32_t r = 0; r < num_range_bins; ++r)
+        {
+            m_a_real[r] = row_a[r].data[REAL];
+            m_a_imag[r] = row_a[r].data[IMAG];
+            m_b_real[r] = row_b[r].data[REAL];
+            m_b_imag[r] = row_b[r].data[IMAG];
+        }
+
+        const float* __restrict a_real = m_a_real;
+        const float* __restrict a_imag = m_a_imag;
+        const float* __restrict b_real = m_b_real;
+        const float* __restrict b_imag = m_b_imag;
+
+        for (uint32_t k = 0; k < RANGE_ANGLE_NUM_BINS; ++k)
+        {
+            const float w_real = steering_real[k];
+            const float w_imag = steering_imag[k];
+
+            float* __restrict out = m_map + k * num_range_bins;
+
+            for (uint32_t r = 0; r < num_range_bins; ++r)
+            {
+                float real = a_real[r] + w_real * b_real[r] - w_imag * b_imag[r];
+                float imag = a_imag[r] + w_real * b_imag[r] + w_imag * b_real[r];
+
+                out[r] += real * real + imag * imag;
+            }
+        }
+    }
+}
+
+const float* range_angle::get_map()
+{
+    return m_map;
+}
+
+json range_angle::create_json()
+{
+    json data;
+
+    data["angle_bins"] = RANGE_ANGLE_NUM_BINS;
+    data["range_bins"] = m_num_range_bins;
+    data["map"] = std::vector<float>(m_map, m_map + RANGE_ANGLE_NUM_BINS * m_num_range_bins);
+
+    return data;
+}
+
+void range_angle::write_json(json_writer* writer)
+{
+    // Keys in the order a json object keeps them
+    writer->begin_object();
+
+    writer->key("angle_bins");
+    writer->value((int32_t) RANGE_ANGLE_NUM_BINS);
+    writer->key("map");
+    writer->values(m_map, RANGE_ANGLE_NUM_BINS * m_num_range_bins);
+    writer->key("range_bins");
+    writer->value(m_num_range_bins);
+
+    writer->end_object();
+}
@@ -0,0 +1,137 @@
+#include "replay_source.hpp"
+
+#include <string.h>
+
+replay_source::replay_source(radar_config* rc) : m_radar_config(rc)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+replay_source::~replay_source()
+{
+    if (m_frame_valid)
+    {
+        ifx_device_destroy_frame(&m_frame);
+    }
+}
+
+bool replay_source::open(const std::string& path, std::string* error)
+{
+    m_file.open(path, std::ios::binary);
+
+    if (!m_file.is_open())
+    {
+        *error = "can't open " + path;
+        return false;
+    }
+
+    if (!m_file.read((char*) &m_header, sizeof(m_header)) ||
+        memcmp(m_header.magic, FRAME_CAPTURE_MAGIC, sizeof(m_header.magic)) != 0)
+    {
+        *error = path + " is not a frame capture";
+        return false;
+    }
+
+    if (m_header.version != FRAME_CAPTURE_VERSION)
+    {
+        *error = path + " has an unsupported capture version";
+        return false;
+    }
+
+    if (!this->matches_config())
+    {
+        *error = path + " was recorded with different dimensions than the config";
+        return false;
+    }
+
+    if (ifx_device_create_frame(m_header.num_rx, m_header.num_chirps, m_header.num_samples, &m_frame))
+    {
+        *error = "can't allocate a frame";
+        return false;
+    }
+
+    m_frame_valid = true;
+    m_finished = false;
+
+    return true;
+}
+
+void replay_source::set_loop(bool loop)
+{
+    m_loop = loop;
+}
+
+bool replay_source::matches_config()
+{
+    ifx_Device_Config_t* config = m_radar_config->get_device_config();
+
+    uint32_t num_rx = 0;
+    for (uint8_t mask = config->rx_antenna_mask; mask != 0; mask >>= 1)
+    {
+        num_rx += mask & 1;
+    }
+
+    return m_header.num_rx == num_rx &&
+           m_header.num_chirps == config->num_chirps_per_frame &&
+           m_header.num_samples == config->num_samples_per_chirp;
+}
+
+bool replay_source::read_frame()
+{
+    for (uint32_t antenna = 0; antenna < m_frame.num_rx; ++antenna)
+    {
+        ifx_Matrix_R_t* rx_data = &(m_frame.rx_data[antenna]);
+
+        if (!m_file.read((char*) rx_data->data, rx_data->rows * rx_data->columns * sizeof(ifx_Float_t)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ifx_Error_t replay_source::pull_frame()
+{
+    if (m_finished)
+    {
+        return IFX_ERROR_TIMEOUT;
+    }
+
+    this->wait_for_next_frame(m_radar_config->get_device_metrics()->m_frame_rate);
+
+    if (this->read_frame())
+    {
+        return IFX_OK;
+    }
+
+    if (m_loop)
+    {
+        m_file.clear();
+        m_file.seekg(sizeof(m_header));
+
+        if (this->read_frame())
+        {
+            return IFX_OK;
+        }
+    }
+
+    m_finished = true;
+
+    return IFX_ERROR_TIMEOUT;
+}
+
+ifx_Frame_t replay_source::get_frame()
+{
+    return m_frame;
+}
+
+ifx_Error_t replay_source::reconfigure()
+{
+    return this->matches_config() ? IFX_OK : IFX_ERROR_DIMENSION_MISMATCH;
+}
+
+bool replay_source::finished()
+{
+    return m_finished;
+}
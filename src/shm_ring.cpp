@@ -0,0 +1,389 @@
+#include "shm_ring.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Slots start on cache lines so neighbouring slots don't share one
+#define SHM_RING_ALIGNMENT 64
+
+static size_t align_up(size_t size)
+{
+    return (size + SHM_RING_ALIGNMENT - 1) / SHM_RING_ALIGNMENT * SHM_RING_ALIGNMENT;
+}
+
+static size_t header_size()
+{
+    return align_up(sizeof(shm_ring_header_t));
+}
+
+#ifdef __linux__
+// Shared between processes, so no FUTEX_PRIVATE_FLAG
+static void futex_wake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, (uint32_t*) word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void futex_wait(std::atomic<uint32_t>* word, uint32_t value, uint32_t timeout_ms)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    syscall(SYS_futex, (uint32_t*) word, FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+#endif
+
+shm_ring_writer::shm_ring_writer(const std::string& name, uint32_t num_slots, uint32_t slot_size) : m_name(name),
+                                                                                                    m_num_slots(num_slots),
+                                                                                                    m_slot_size(slot_size)
+{
+
+}
+
+shm_ring_writer::~shm_ring_writer()
+{
+#ifdef __linux__
+    if (m_memory != nullptr)
+    {
+        // Readers mapped to this ring would otherwise wait on it forever
+        m_header->closed.store(1, std::memory_order_release);
+        m_header->notify.fetch_add(1, std::memory_order_release);
+        futex_wake(&m_header->notify);
+
+        munmap(m_memory, m_size);
+        shm_unlink(m_name.c_str());
+    }
+#endif
+}
+
+bool shm_ring_writer::open(std::string* error)
+{
+#ifdef __linux__
+    if (m_num_slots == 0 || (m_num_slots & (m_num_slots - 1)) != 0)
+    {
+        *error = "the number of slots has to be a power of two";
+        return false;
+    }
+
+    size_t slot_stride = align_up(sizeof(shm_ring_slot_t) + m_slot_size);
+    m_size = header_size() + m_num_slots * slot_stride;
+
+    // A ring left behind by a crashed writer is replaced
+    shm_unlink(m_name.c_str());
+
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+
+    if (fd < 0 || ftruncate(fd, m_size) != 0)
+    {
+        *error = "can't create shared memory " + m_name + ": " + strerror(errno);
+        if (fd >= 0)
+        {
+            close(fd);
+            shm_unlink(m_name.c_str());
+        }
+        return false;
+    }
+
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        *error = "can't map shared memory " + m_name + ": " + strerror(errno);
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    m_memory = (uint8_t*) memory;
+    m_header = (shm_ring_header_t*) m_memory;
+
+    m_header->num_slots = m_num_slots;
+    m_header->slot_size = m_slot_size;
+    m_header->slot_stride = (uint32_t) slot_stride;
+    m_header->head.store(0);
+    m_header->notify.store(0);
+    m_header->waiters.store(0);
+    m_header->closed.store(0);
+
+    for (uint32_t i = 0; i < m_num_slots; ++i)
+    {
+        this->get_slot(i)->state.store(0);
+    }
+
+    m_header->version = SHM_RING_VERSION;
+
+    // Readers check the magic last, by then everything else is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = SHM_RING_MAGIC;
+
+    return true;
+#else
+    *error = "shared memory output is only supported on Linux";
+    return false;
+#endif
+}
+
+shm_ring_slot_t* shm_ring_writer::get_slot(uint32_t message)
+{
+    return (shm_ring_slot_t*) (m_memory + header_size() + (size_t) (message & (m_num_slots - 1)) * m_header->slot_stride);
+}
+
+void shm_ring_writer::send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable)
+{
+    (void) droppable;
+
+    size_t length = boost::asio::buffer_size(buffers);
+
+    if (m_memory == nullptr || length > m_slot_size)
+    {
+        m_dropped_bytes += length;
+        ++m_dropped_messages;
+        return;
+    }
+
+    uint32_t message = m_head;
+    shm_ring_slot_t* slot = this->get_slot(message);
+
+    // Readers still on the old message of this slot see it change from here on
+    slot->state.store(2 * message + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* payload = (uint8_t*) (slot + 1);
+    for (const boost::asio::const_buffer& buffer : buffers)
+    {
+        memcpy(payload, buffer.data(), buffer.size());
+        payload += buffer.size();
+    }
+    slot->length = (uint32_t) length;
+
+    slot->state.store(2 * message + 2, std::memory_order_release);
+
+    m_head = message + 1;
+    m_header->head.store(m_head, std::memory_order_release);
+    m_header->notify.fetch_add(1, std::memory_order_release);
+
+    // Nobody asleep, no syscall
+#ifdef __linux__
+    if (m_header->waiters.load() > 0)
+    {
+        futex_wake(&m_header->notify);
+    }
+#endif
+
+    m_sent_bytes += length;
+}
+
+bool shm_ring_writer::failed()
+{
+    return false;
+}
+
+std::string shm_ring_writer::get_error()
+{
+    return std::string();
+}
+
+packet_sink_stats_t shm_ring_writer::get_stats()
+{
+    packet_sink_stats_t stats;
+    stats.queued_bytes = 0;
+    stats.sent_bytes = m_sent_bytes;
+    stats.dropped_bytes = m_dropped_bytes;
+    stats.dropped_messages = m_dropped_messages;
+    stats.reconnects = 0;
+
+    return stats;
+}
+
+shm_ring_reader::shm_ring_reader(const std::string& name) : m_name(name)
+{
+
+}
+
+shm_ring_reader::~shm_ring_reader()
+{
+#ifdef __linux__
+    if (m_memory != nullptr)
+    {
+        munmap(m_memory, m_size);
+    }
+#endif
+}
+
+bool shm_ring_reader::open(std::string* error)
+{
+#ifdef __linux__
+    if (m_memory != nullptr)
+    {
+        munmap(m_memory, m_size);
+        m_memory = nullptr;
+        m_header = nullptr;
+    }
+
+    // Read-write, waiting readers register in the header
+    int fd = shm_open(m_name.c_str(), O_RDWR, 0);
+
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t) info.st_size < header_size())
+    {
+        *error = "can't open shared memory " + m_name + ": " + strerror(errno);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    m_size = info.st_size;
+    m_device = info.st_dev;
+    m_inode = info.st_ino;
+
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        *error = "can't map shared memory " + m_name + ": " + strerror(errno);
+        return false;
+    }
+
+    m_memory = (uint8_t*) memory;
+    m_header = (shm_ring_header_t*) m_memory;
+
+    bool valid = m_header->magic == SHM_RING_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (!valid || m_header->version != SHM_RING_VERSION ||
+        header_size() + (size_t) m_header->num_slots * m_header->slot_stride > m_size)
+    {
+        *error = m_name + " is not a ring of this version, or not set up yet";
+        munmap(m_memory, m_size);
+        m_memory = nullptr;
+        return false;
+    }
+
+    m_next = m_header->head.load(std::memory_order_acquire);
+
+    return true;
+#else
+    *error = "shared memory output is only supported on Linux";
+    return false;
+#endif
+}
+
+shm_ring_slot_t* shm_ring_reader::get_slot(uint32_t message)
+{
+    return (shm_ring_slot_t*) (m_memory + header_size() + (size_t) (message & (m_header->num_slots - 1)) * m_header->slot_stride);
+}
+
+shm_ring_status_t shm_ring_reader::next(const uint8_t** data, size_t* length, uint32_t timeout_ms)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (true)
+    {
+        uint32_t head = m_header->head.load(std::memory_order_acquire);
+
+        // Lapped, skip to the oldest message that can still be there
+        if (head - m_next > m_header->num_slots)
+        {
+            m_lost += head - m_header->num_slots - m_next;
+            m_next = head - m_header->num_slots;
+        }
+
+        if (m_next != head)
+        {
+            shm_ring_slot_t* slot = this->get_slot(m_next);
+
+            if (slot->state.load(std::memory_order_acquire) == 2 * m_next + 2)
+            {
+                *data = (const uint8_t*) (slot + 1);
+                *length = std::min((size_t) slot->length, (size_t) m_header->slot_size);
+
+                m_current = m_next++;
+                return SHM_RING_OK;
+            }
+
+            // Already overwritten by a newer message
+            ++m_lost;
+            ++m_next;
+            continue;
+        }
+
+        if (m_header->closed.load(std::memory_order_acquire))
+        {
+            return SHM_RING_CLOSED;
+        }
+
+        // Signals and spurious wake-ups end a wait early as well
+        int64_t remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining_ms <= 0)
+        {
+            return SHM_RING_TIMEOUT;
+        }
+
+#ifdef __linux__
+        uint32_t notify = m_header->notify.load(std::memory_order_acquire);
+
+        m_header->waiters.fetch_add(1);
+
+        // The writer may have published or closed between the checks and registering as a waiter
+        if (m_header->head.load(std::memory_order_acquire) == m_next && !m_header->closed.load(std::memory_order_acquire))
+        {
+            futex_wait(&m_header->notify, notify, (uint32_t) remaining_ms);
+        }
+
+        m_header->waiters.fetch_sub(1);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+bool shm_ring_reader::replaced()
+{
+#ifdef __linux__
+    int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+
+    // Nothing under the name yet, nothing to switch to
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    bool other = fstat(fd, &info) == 0 && ((uint64_t) info.st_dev != m_device || (uint64_t) info.st_ino != m_inode);
+    close(fd);
+
+    return other;
+#else
+    return false;
+#endif
+}
+
+bool shm_ring_reader::validate()
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return this->get_slot(m_current)->state.load(std::memory_order_relaxed) == 2 * m_current + 2;
+}
+
+uint64_t shm_ring_reader::get_lost()
+{
+    return m_lost;
+}
@@ -0,0 +1,218 @@
+#include "slow_time_reader.hpp"
+
+#include <string.h>
+
+#include <fstream>
+
+// The only column layout slow_time_recorder writes
+static bool has_known_columns(const json& schema, uint32_t num_bins)
+{
+    json columns = {
+        {{"name", "timestamp_us"}, {"type", "u64"}, {"width", 1}},
+        {{"name", "sequence"}, {"type", "u32"}, {"width", 1}},
+        {{"name", "real"}, {"type", "f32"}, {"width", num_bins}},
+        {{"name", "imag"}, {"type", "f32"}, {"width", num_bins}}
+    };
+
+    return schema.value("columns", json()) == columns;
+}
+
+static size_t get_row_size(uint32_t num_bins)
+{
+    return sizeof(uint64_t) + sizeof(uint32_t) + 2 * (size_t) num_bins * sizeof(float);
+}
+
+slow_time_reader::slow_time_reader()
+{
+
+}
+
+slow_time_reader::~slow_time_reader()
+{
+
+}
+
+bool slow_time_reader::open(const std::string& path, std::string* error)
+{
+    m_segments.clear();
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        *error = "can't open " + path;
+        return false;
+    }
+
+    std::vector<uint8_t> data((size_t) file.tellg());
+    file.seekg(0);
+    file.read((char*) data.data(), data.size());
+
+    slow_time_file_header_t header;
+
+    if (!file || data.size() < sizeof(header))
+    {
+        *error = "can't read " + path;
+        return false;
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (memcmp(header.magic, SLOW_TIME_RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version != SLOW_TIME_RECORDING_VERSION)
+    {
+        *error = path + " is not a slow-time recording of this version";
+        return false;
+    }
+
+    // First the schemas and the row counts, then the rows straight into their final place
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        size_t offset = sizeof(header);
+        int32_t segment_index = -1;
+        uint32_t row = 0;
+
+        slow_time_chunk_header_t chunk;
+
+        while (offset + sizeof(chunk) <= data.size())
+        {
+            memcpy(&chunk, data.data() + offset, sizeof(chunk));
+
+            if (offset + sizeof(chunk) + chunk.length > data.size())
+            {
+                break;
+            }
+
+            const uint8_t* payload = data.data() + offset + sizeof(chunk);
+            size_t chunk_offset = offset;
+            offset += sizeof(chunk) + chunk.length;
+
+            if (chunk.type == SLOW_TIME_CHUNK_SCHEMA)
+            {
+                ++segment_index;
+                row = 0;
+
+                if (pass == 1)
+                {
+                    continue;
+                }
+
+                json schema = json::parse(payload, payload + chunk.length, nullptr, false);
+
+                slow_time_segment_t segment;
+                segment.num_bins = 0;
+
+                if (!schema.is_discarded() && schema.is_object())
+                {
+                    segment.metrics = schema.value("metrics", json::object());
+                    segment.first_bin = schema.value("first_bin", 0u);
+                    segment.num_bins = schema.value("num_bins", 0u);
+                    segment.num_points = schema.value("num_points", 0u);
+                }
+
+                if (segment.num_bins == 0 || !has_known_columns(schema, segment.num_bins))
+                {
+                    *error = path + ": unknown schema at byte " + std::to_string(chunk_offset);
+                    m_segments.clear();
+                    return false;
+                }
+
+                segment.num_rows = 0;
+                segment.num_spectra = 0;
+
+                m_segments.push_back(segment);
+                continue;
+            }
+
+            if (segment_index < 0)
+            {
+                *error = path + ": data before the first schema";
+                m_segments.clear();
+                return false;
+            }
+
+            slow_time_segment_t* segment = &m_segments[segment_index];
+
+            if (chunk.type == SLOW_TIME_CHUNK_ROWS)
+            {
+                slow_time_rows_header_t rows;
+                if (chunk.length < sizeof(rows))
+                {
+                    *error = path + ": short rows chunk at byte " + std::to_string(chunk_offset);
+                    m_segments.clear();
+                    return false;
+                }
+                memcpy(&rows, payload, sizeof(rows));
+
+                if (sizeof(rows) + rows.num_rows * get_row_size(segment->num_bins) != chunk.length)
+                {
+                    *error = path + ": rows chunk at byte " + std::to_string(chunk_offset) + " doesn't match its schema";
+                    m_segments.clear();
+                    return false;
+                }
+
+                if (pass == 0)
+                {
+                    segment->num_rows += rows.num_rows;
+                    continue;
+                }
+
+                const uint8_t* column = payload + sizeof(rows);
+
+                memcpy(&segment->timestamps_us[row], column, rows.num_rows * sizeof(uint64_t));
+                column += rows.num_rows * sizeof(uint64_t);
+
+                memcpy(&segment->sequences[row], column, rows.num_rows * sizeof(uint32_t));
+                column += rows.num_rows * sizeof(uint32_t);
+
+                std::vector<float>* values[] = {&segment->real, &segment->imag};
+                for (std::vector<float>* value : values)
+                {
+                    for (uint32_t bin = 0; bin < segment->num_bins; ++bin)
+                    {
+                        memcpy(&(*value)[(size_t) bin * segment->num_rows + row], column, rows.num_rows * sizeof(float));
+                        column += rows.num_rows * sizeof(float);
+                    }
+                }
+
+                row += rows.num_rows;
+            }
+            else if (chunk.type == SLOW_TIME_CHUNK_SPECTRA && pass == 0)
+            {
+                ++segment->num_spectra;
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (slow_time_segment_t& segment : m_segments)
+            {
+                segment.timestamps_us.resize(segment.num_rows);
+                segment.sequences.resize(segment.num_rows);
+                segment.real.resize((size_t) segment.num_bins * segment.num_rows);
+                segment.imag.resize((size_t) segment.num_bins * segment.num_rows);
+            }
+        }
+    }
+
+    return true;
+}
+
+const std::vector<slow_time_segment_t>& slow_time_reader::get_segments()
+{
+    return m_segments;
+}
+
+const slow_time_segment_t* slow_time_reader::get_longest_segment()
+{
+    const slow_time_segment_t* longest = nullptr;
+
+    for (const slow_time_segment_t& segment : m_segments)
+    {
+        if (segment.num_rows > 0 && (longest == nullptr || segment.num_rows > longest->num_rows))
+        {
+            longest = &segment;
+        }
+    }
+
+    return longest;
+}
@@ -0,0 +1,207 @@
+#include "slow_time_recorder.hpp"
+
+#include <string.h>
+#include <unistd.h>
+
+slow_time_recorder::slow_time_recorder(uint32_t chunk_rows) : m_chunk_rows(chunk_rows)
+{
+
+}
+
+slow_time_recorder::~slow_time_recorder()
+{
+    this->flush();
+    m_file.close();
+}
+
+bool slow_time_recorder::open(const std::string& path, std::string* error)
+{
+    slow_time_file_header_t header;
+
+    std::ifstream existing(path, std::ios::binary | std::ios::ate);
+    size_t size = existing.is_open() ? (size_t) existing.tellg() : 0;
+
+    if (size > 0)
+    {
+        existing.seekg(0);
+        existing.read((char*) &header, sizeof(header));
+
+        if (!existing || memcmp(header.magic, SLOW_TIME_RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version != SLOW_TIME_RECORDING_VERSION)
+        {
+            *error = path + " exists and is not a slow-time recording of this version";
+            return false;
+        }
+
+        // Everything up to the last complete chunk stays
+        size_t end = sizeof(header);
+        slow_time_chunk_header_t chunk;
+
+        while (end + sizeof(chunk) <= size)
+        {
+            existing.seekg(end);
+            existing.read((char*) &chunk, sizeof(chunk));
+
+            if (!existing || end + sizeof(chunk) + chunk.length > size)
+            {
+                break;
+            }
+
+            end += sizeof(chunk) + chunk.length;
+        }
+
+        existing.close();
+
+        if (end < size && truncate(path.c_str(), end) != 0)
+        {
+            *error = "can't cut the partial chunk off " + path;
+            return false;
+        }
+
+        m_file.open(path, std::ios::binary | std::ios::app);
+    }
+    else
+    {
+        existing.close();
+
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+
+        memcpy(header.magic, SLOW_TIME_RECORDING_MAGIC, sizeof(header.magic));
+        header.version = SLOW_TIME_RECORDING_VERSION;
+
+        m_file.write((const char*) &header, sizeof(header));
+    }
+
+    if (!m_file.is_open())
+    {
+        *error = "can't write " + path;
+        return false;
+    }
+
+    m_file.flush();
+
+    return true;
+}
+
+void slow_time_recorder::begin(const json& metrics, uint32_t first_bin, uint32_t num_bins, uint32_t num_points)
+{
+    // Rows of the old schema go out under it
+    this->flush();
+
+    m_num_bins = num_bins;
+    m_num_points = num_points;
+
+    m_timestamps.resize(m_chunk_rows);
+    m_sequences.resize(m_chunk_rows);
+    m_real.resize((size_t) m_chunk_rows * num_bins);
+    m_imag.resize((size_t) m_chunk_rows * num_bins);
+
+    json schema;
+    schema["metrics"] = metrics;
+    schema["first_bin"] = first_bin;
+    schema["num_bins"] = num_bins;
+    schema["num_points"] = num_points;
+    schema["columns"] = {
+        {{"name", "timestamp_us"}, {"type", "u64"}, {"width", 1}},
+        {{"name", "sequence"}, {"type", "u32"}, {"width", 1}},
+        {{"name", "real"}, {"type", "f32"}, {"width", num_bins}},
+        {{"name", "imag"}, {"type", "f32"}, {"width", num_bins}}
+    };
+
+    std::string text = schema.dump();
+
+    this->write_chunk_header(SLOW_TIME_CHUNK_SCHEMA, text.size());
+    m_file.write(text.data(), text.size());
+    m_file.flush();
+}
+
+void slow_time_recorder::add_row(uint64_t timestamp_us, uint32_t sequence, const float* real, const float* imag)
+{
+    if (!m_file.is_open() || m_num_bins == 0)
+    {
+        return;
+    }
+
+    m_timestamps[m_num_rows] = timestamp_us;
+    m_sequences[m_num_rows] = sequence;
+
+    for (uint32_t bin = 0; bin < m_num_bins; ++bin)
+    {
+        m_real[(size_t) bin * m_chunk_rows + m_num_rows] = real[bin];
+        m_imag[(size_t) bin * m_chunk_rows + m_num_rows] = imag[bin];
+    }
+
+    ++m_num_rows;
+
+    if (m_num_rows == m_chunk_rows)
+    {
+        this->flush();
+    }
+}
+
+void slow_time_recorder::add_spectra(uint64_t timestamp_us, uint32_t sequence, const float* magnitudes)
+{
+    if (!m_file.is_open() || m_num_bins == 0)
+    {
+        return;
+    }
+
+    slow_time_spectra_header_t header;
+    header.timestamp_us = timestamp_us;
+    header.sequence = sequence;
+    header.num_points = m_num_points;
+
+    size_t values_size = (size_t) m_num_bins * m_num_points * sizeof(float);
+
+    this->write_chunk_header(SLOW_TIME_CHUNK_SPECTRA, sizeof(header) + values_size);
+    m_file.write((const char*) &header, sizeof(header));
+    m_file.write((const char*) magnitudes, values_size);
+    m_file.flush();
+}
+
+void slow_time_recorder::flush()
+{
+    if (!m_file.is_open() || m_num_rows == 0)
+    {
+        return;
+    }
+
+    slow_time_rows_header_t header;
+    header.num_rows = m_num_rows;
+    header.reserved = 0;
+
+    size_t row_size = sizeof(uint64_t) + sizeof(uint32_t) + 2 * m_num_bins * sizeof(float);
+
+    this->write_chunk_header(SLOW_TIME_CHUNK_ROWS, sizeof(header) + m_num_rows * row_size);
+    m_file.write((const char*) &header, sizeof(header));
+    m_file.write((const char*) m_timestamps.data(), m_num_rows * sizeof(uint64_t));
+    m_file.write((const char*) m_sequences.data(), m_num_rows * sizeof(uint32_t));
+    this->write_column(m_real.data());
+    this->write_column(m_imag.data());
+
+    // Readers following the file get every chunk as soon as it is complete
+    m_file.flush();
+
+    m_num_rows = 0;
+}
+
+uint32_t slow_time_recorder::get_num_bins()
+{
+    return m_num_bins;
+}
+
+void slow_time_recorder::write_chunk_header(slow_time_chunk_type_t type, size_t length)
+{
+    slow_time_chunk_header_t chunk;
+    chunk.type = type;
+    chunk.length = (uint32_t) length;
+
+    m_file.write((const char*) &chunk, sizeof(chunk));
+}
+
+void slow_time_recorder::write_column(const float* column)
+{
+    for (uint32_t bin = 0; bin < m_num_bins; ++bin)
+    {
+        m_file.write((const char*) (column + (size_t) bin * m_chunk_rows), m_num_rows * sizeof(float));
+    }
+}
@@ -0,0 +1,174 @@
+#include "spectrogram.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#define REAL 0
+#define IMAG 1
+
+spectrogram::spectrogram(radar_config* radar_config, uint32_t num_rows) : m_radar_config(radar_config),
+                                                                          m_num_rows(num_rows)
+{
+    m_image = new float[SPECTROGRAM_NUM_COLUMNS * m_num_rows];
+    m_tile = new float[SPECTROGRAM_NUM_COLUMNS * m_num_rows];
+    m_tile_quantised = new uint8_t[SPECTROGRAM_NUM_COLUMNS * m_num_rows];
+
+    this->reset();
+}
+
+spectrogram::~spectrogram()
+{
+    delete[] m_image;
+    delete[] m_tile;
+    delete[] m_tile_quantised;
+}
+
+void spectrogram::reset()
+{
+    m_head = 0;
+    m_filled = 0;
+    m_since_tile = 0;
+}
+
+void spectrogram::add_column(const ifx_Vector_C_t* doppler_spectrum)
+{
+    float* column = m_image + m_head * m_num_rows;
+
+    for (uint32_t i = 0; i < m_num_rows && i < doppler_spectrum->length; ++i)
+    {
+        ifx_Complex_t element = doppler_spectrum->data[i];
+        float power = element.data[REAL] * element.data[REAL] + element.data[IMAG] * element.data[IMAG];
+
+        // Small offset keeps empty bins finite
+        column[i] = 10.0f * log10f(power + 1e-20f);
+    }
+
+    m_head = (m_head + 1) % SPECTROGRAM_NUM_COLUMNS;
+
+    if (m_filled < SPECTROGRAM_NUM_COLUMNS)
+    {
+        m_filled += 1;
+    }
+
+    m_since_tile += 1;
+}
+
+bool spectrogram::tile_ready()
+{
+    return m_filled == SPECTROGRAM_NUM_COLUMNS && m_since_tile >= SPECTROGRAM_HOP;
+}
+
+void spectrogram::get_tile(float* tile)
+{
+    // Unroll the ring, columns from m_head to the end are the oldest
+    uint32_t older = SPECTROGRAM_NUM_COLUMNS - m_head;
+
+    memcpy(tile, m_image + m_head * m_num_rows, older * m_num_rows * sizeof(float));
+    memcpy(tile + older * m_num_rows, m_image, m_head * m_num_rows * sizeof(float));
+
+    m_since_tile = 0;
+}
+
+void spectrogram::get_tile_quantised(uint8_t* tile)
+{
+    uint32_t size = SPECTROGRAM_NUM_COLUMNS * m_num_rows;
+
+    float peak = -INFINITY;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        if (m_image[i] > peak)
+        {
+            peak = m_image[i];
+        }
+    }
+
+    float floor_db = peak - SPECTROGRAM_DYNAMIC_RANGE_DB;
+    float scale = 255.0f / SPECTROGRAM_DYNAMIC_RANGE_DB;
+
+    uint32_t index = 0;
+    for (uint32_t c = 0; c < SPECTROGRAM_NUM_COLUMNS; ++c)
+    {
+        const float* column = m_image + ((m_head + c) % SPECTROGRAM_NUM_COLUMNS) * m_num_rows;
+
+        for (uint32_t r = 0; r < m_num_rows; ++r, ++index)
+        {
+            float value = (column[r] - floor_db) * scale;
+
+            if (value < 0.0f)
+            {
+                value = 0.0f;
+            }
+            else if (value > 255.0f)
+            {
+                value = 255.0f;
+            }
+
+            tile[index] = (uint8_t) (value + 0.5f);
+        }
+    }
+
+    m_since_tile = 0;
+}
+
+uint32_t spectrogram::get_num_rows()
+{
+    return m_num_rows;
+}
+
+uint32_t spectrogram::get_num_columns()
+{
+    return SPECTROGRAM_NUM_COLUMNS;
+}
+
+json spectrogram::create_json(bool quantised)
+{
+    json data;
+
+    data["columns"] = SPECTROGRAM_NUM_COLUMNS;
+    data["rows"] = m_num_rows;
+    data["quantised"] = quantised;
+
+    if (quantised)
+    {
+        std::vector<uint8_t> tile(SPECTROGRAM_NUM_COLUMNS * m_num_rows);
+        this->get_tile_quantised(tile.data());
+        data["tile"] = tile;
+    }
+    else
+    {
+        std::vector<float> tile(SPECTROGRAM_NUM_COLUMNS * m_num_rows);
+        this->get_tile(tile.data());
+        data["tile"] = tile;
+    }
+
+    return data;
+}
+
+void spectrogram::write_json(json_writer* writer, bool quantised)
+{
+    // Keys in the order a json object keeps them
+    writer->begin_object();
+
+    writer->key("columns");
+    writer->value((int32_t) SPECTROGRAM_NUM_COLUMNS);
+    writer->key("quantised");
+    writer->value(quantised);
+    writer->key("rows");
+    writer->value(m_num_rows);
+    writer->key("tile");
+
+    if (quantised)
+    {
+        this->get_tile_quantised(m_tile_quantised);
+        writer->values(m_tile_quantised, SPECTROGRAM_NUM_COLUMNS * m_num_rows);
+    }
+    else
+    {
+        this->get_tile(m_tile);
+        writer->values(m_tile, SPECTROGRAM_NUM_COLUMNS * m_num_rows);
+    }
+
+    writer->end_object();
+}
@@ -0,0 +1,180 @@
+#include "subscriber_server.hpp"
+
+#include <iostream>
+
+using boost::asio::ip::tcp;
+
+subscriber_server::subscriber_server(uint16_t port, tcp_mode_t tcp_mode, drop_policy_t drop_policy, size_t max_queue_bytes, unsigned int timeout_ms) :
+    m_port(port),
+    m_tcp_mode(tcp_mode),
+    m_drop_policy(drop_policy),
+    m_max_queue_bytes(max_queue_bytes),
+    m_timeout_ms(timeout_ms),
+    m_acceptor(m_io_service),
+    m_running(false)
+{
+
+}
+
+subscriber_server::~subscriber_server()
+{
+    if (m_running)
+    {
+        m_running = false;
+        m_thread.join();
+    }
+
+    boost::system::error_code error;
+    m_acceptor.close(error);
+
+    for (connection* subscriber : m_new)
+    {
+        delete subscriber;
+    }
+}
+
+void subscriber_server::set_compression_bounds(float max_error_db, float dynamic_range_db)
+{
+    m_max_error_db = max_error_db;
+    m_dynamic_range_db = dynamic_range_db;
+}
+
+bool subscriber_server::open(std::string* error)
+{
+    boost::system::error_code ec;
+
+    tcp::endpoint endpoint(tcp::v4(), m_port);
+
+    m_acceptor.open(endpoint.protocol(), ec);
+    if (!ec)
+    {
+        m_acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
+        m_acceptor.bind(endpoint, ec);
+    }
+    if (!ec)
+    {
+        m_acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+    }
+    if (!ec)
+    {
+        // Lets the accept thread look at m_running now and then
+        m_acceptor.non_blocking(true, ec);
+    }
+
+    if (ec)
+    {
+        *error = ec.message();
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&subscriber_server::accept_loop, this);
+
+    return true;
+}
+
+std::vector<connection*> subscriber_server::take_new()
+{
+    std::vector<connection*> subscribers;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    subscribers.swap(m_new);
+
+    return subscribers;
+}
+
+void subscriber_server::accept_loop()
+{
+    // Waits for the next subscriber, kept across polls so its io thread isn't started every time
+    packet_sender* sender = nullptr;
+
+    while (m_running)
+    {
+        if (sender == nullptr)
+        {
+            sender = new packet_sender(m_tcp_mode, m_drop_policy, m_max_queue_bytes);
+        }
+
+        std::string error;
+        if (!sender->accept(m_acceptor, m_timeout_ms, &error))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SUBSCRIBER_SERVER_POLL_MS));
+            continue;
+        }
+
+        connection* subscriber = this->subscribe(sender);
+        sender = nullptr;
+
+        if (subscriber != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_new.push_back(subscriber);
+        }
+    }
+
+    delete sender;
+}
+
+connection* subscriber_server::subscribe(packet_sender* sender)
+{
+    std::string request_text;
+    std::string error;
+
+    if (!sender->read_message(&request_text, SUBSCRIBER_SERVER_MAX_REQUEST, SUBSCRIBER_SERVER_REQUEST_TIMEOUT_MS, &error))
+    {
+        std::cerr << "Dropping subscriber without a request: " << error << std::endl;
+        delete sender;
+        return nullptr;
+    }
+
+    json request = json::parse(request_text, nullptr, false);
+
+    uint32_t topics = DSP_DEFAULT_STAGES;
+    uint32_t divisor = 1;
+    encoding_t encoding = ENCODING_BINARY;
+    compression_t compression = COMPRESSION_NONE;
+
+    bool valid = request.is_object();
+
+    if (valid && request.contains("topics"))
+    {
+        valid = request["topics"].is_array();
+        topics = 0;
+
+        for (uint32_t i = 0; valid && i < request["topics"].size(); ++i)
+        {
+            uint32_t topic;
+
+            valid = request["topics"][i].is_string() && dsp::parse_stage(request["topics"][i].get<std::string>(), &topic);
+            topics |= valid ? topic : 0;
+        }
+    }
+
+    if (valid && request.contains("divisor"))
+    {
+        valid = request["divisor"].is_number_unsigned() && request["divisor"].get<uint32_t>() > 0;
+        divisor = valid ? request["divisor"].get<uint32_t>() : 1;
+    }
+
+    if (valid && request.contains("encoding"))
+    {
+        valid = request["encoding"].is_string() && parse_encoding(request["encoding"].get<std::string>(), &encoding);
+    }
+
+    if (valid && request.contains("compression"))
+    {
+        valid = request["compression"].is_string() && parse_compression(request["compression"].get<std::string>(), &compression);
+    }
+
+    if (!valid)
+    {
+        std::cerr << "Dropping subscriber with a bad request: " << request_text << std::endl;
+        delete sender;
+        return nullptr;
+    }
+
+    connection* subscriber = new connection(sender, encoding, topics, divisor);
+    subscriber->set_compression(compression, m_max_error_db, m_dynamic_range_db);
+
+    return subscriber;
+}
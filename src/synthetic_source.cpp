@@ -0,0 +1,126 @@
+#include "synthetic_source.hpp"
+
+#include <math.h>
+
+synthetic_source::synthetic_source(radar_config* rc) : m_radar_config(rc),
+                                                         m_generator(SYNTHETIC_NOISE_SEED),
+                                                         m_noise(0.0f, SYNTHETIC_NOISE_SIGMA)
+{
+    m_frame.num_rx = 0;
+    m_frame.rx_data = nullptr;
+}
+
+synthetic_source::~synthetic_source()
+{
+    if (m_frame.rx_data != nullptr)
+    {
+        ifx_device_destroy_frame(&m_frame);
+    }
+}
+
+bool synthetic_source::open(std::string* error)
+{
+    ifx_Error_t err = this->create_frame();
+
+    if (err != IFX_OK)
+    {
+        *error = "can't allocate a synthetic frame, SDK error " + std::to_string(err);
+        return false;
+    }
+
+    return true;
+}
+
+ifx_Error_t synthetic_source::create_frame()
+{
+    ifx_Device_Config_t* config = m_radar_config->get_device_config();
+
+    uint8_t num_rx = 0;
+    for (uint8_t mask = config->rx_antenna_mask; mask != 0; mask >>= 1)
+    {
+        num_rx += mask & 1;
+    }
+
+    ifx_Error_t err = ifx_device_create_frame(num_rx, config->num_chirps_per_frame, config->num_samples_per_chirp, &m_frame);
+
+    if (err != IFX_OK)
+    {
+        m_frame.num_rx = 0;
+        m_frame.rx_data = nullptr;
+    }
+
+    return err;
+}
+
+ifx_Error_t synthetic_source::pull_frame()
+{
+    const double c0 = 2.99792458e8;
+
+    // Not opened, or the last reconfigure couldn't allocate
+    if (m_frame.rx_data == nullptr)
+    {
+        return IFX_ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+
+    ifx_Device_Config_t* config = m_radar_config->get_device_config();
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    this->wait_for_next_frame(metrics->m_frame_rate);
+
+    double bandwidth_hz = 1000.0 * (config->upper_frequency_kHz - config->lower_frequency_kHz);
+    double lambda = c0 / (1000.0 * metrics->m_fmcw_center_frequency_khz);
+    double chirp_time_s = 1.0e-10 * config->chirp_to_chirp_time_100ps;
+
+    uint32_t num_samples = config->num_samples_per_chirp;
+
+    // Phase offset of each antenna against RX3 in the corner of the L, half a wavelength apart
+    double antenna_phase[3] =
+    {
+        M_PI * sin(SYNTHETIC_TARGET_AZIMUTH_RAD),
+        M_PI * sin(SYNTHETIC_TARGET_ELEVATION_RAD),
+        0.0
+    };
+
+    for (uint32_t chirp = 0; chirp < config->num_chirps_per_frame; ++chirp)
+    {
+        double t = m_time_s + chirp * chirp_time_s;
+        double range = SYNTHETIC_TARGET_RANGE_M + SYNTHETIC_VIBRATION_AMPLITUDE_M * sin(2.0 * M_PI * SYNTHETIC_VIBRATION_FREQUENCY_HZ * t);
+
+        // Beat frequency per sample, with the chirp spanning all samples: 2 * r * BW / (c0 * N)
+        double sample_phase = 4.0 * M_PI * range * bandwidth_hz / (c0 * num_samples);
+        double carrier_phase = 4.0 * M_PI * range / lambda;
+
+        for (uint32_t antenna = 0; antenna < m_frame.num_rx; ++antenna)
+        {
+            ifx_Float_t* row = m_frame.rx_data[antenna].data + chirp * num_samples;
+            double phase = carrier_phase + antenna_phase[antenna % 3];
+
+            for (uint32_t sample = 0; sample < num_samples; ++sample)
+            {
+                row[sample] = SYNTHETIC_SIGNAL_OFFSET +
+                              SYNTHETIC_SIGNAL_AMPLITUDE * (float) cos(sample_phase * sample + phase) +
+                              m_noise(m_generator);
+            }
+        }
+    }
+
+    // The frame rate may change between frames
+    m_time_s += 1.0 / metrics->m_frame_rate;
+
+    return IFX_OK;
+}
+
+ifx_Frame_t synthetic_source::get_frame()
+{
+    return m_frame;
+}
+
+ifx_Error_t synthetic_source::reconfigure()
+{
+    if (m_frame.rx_data != nullptr)
+    {
+        ifx_device_destroy_frame(&m_frame);
+    }
+
+    return this->create_frame();
+}
@@ -0,0 +1,184 @@
+#include "thread_pool.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+thread_pool::thread_pool(uint32_t num_threads, const std::vector<uint32_t>& cpus) : m_num_threads(num_threads), m_remaining(0)
+{
+    if (m_num_threads == 0)
+    {
+        m_num_threads = std::thread::hardware_concurrency();
+    }
+
+    if (m_num_threads == 0)
+    {
+        m_num_threads = 1;
+    }
+
+    m_queues = new worker_queue_t[m_num_threads];
+
+    // Queue zero belongs to the thread calling run_batch
+    for (uint32_t i = 1; i < m_num_threads; ++i)
+    {
+        m_workers.push_back(std::thread(&thread_pool::worker_loop, this, i));
+    }
+
+#ifdef __linux__
+    for (uint32_t i = 1; i < m_num_threads && !cpus.empty(); ++i)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[i % cpus.size()], &set);
+
+        pthread_setaffinity_np(m_workers[i - 1].native_handle(), sizeof(set), &set);
+    }
+#endif
+}
+
+bool thread_pool::pin_current_thread(uint32_t cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state_lock);
+        m_running = false;
+    }
+    m_wake.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i].join();
+    }
+
+    delete[] m_queues;
+}
+
+uint32_t thread_pool::get_num_threads()
+{
+    return m_num_threads;
+}
+
+void thread_pool::run_batch(uint32_t count, const std::function<void(uint32_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Nothing to gain from queueing when there is nobody to share with
+    if (m_num_threads == 1 || count == 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> batch_lock(m_batch_lock);
+
+    m_task = &task;
+    m_remaining = count;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        worker_queue_t& queue = m_queues[i % m_num_threads];
+
+        std::lock_guard<std::mutex> lock(queue.lock);
+        queue.tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state_lock);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    this->work(0);
+
+    std::unique_lock<std::mutex> lock(m_state_lock);
+    m_done.wait(lock, [this] { return m_remaining.load() == 0; });
+
+    m_task = nullptr;
+}
+
+bool thread_pool::pop_task(uint32_t worker, uint32_t* index)
+{
+    {
+        worker_queue_t& own = m_queues[worker];
+
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.tasks.empty())
+        {
+            *index = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (uint32_t i = 1; i < m_num_threads; ++i)
+    {
+        worker_queue_t& victim = m_queues[(worker + i) % m_num_threads];
+
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            *index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void thread_pool::work(uint32_t worker)
+{
+    uint32_t index;
+
+    while (this->pop_task(worker, &index))
+    {
+        (*m_task)(index);
+
+        if (m_remaining.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_state_lock);
+            m_done.notify_all();
+        }
+    }
+}
+
+void thread_pool::worker_loop(uint32_t worker)
+{
+    uint64_t seen_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_state_lock);
+            m_wake.wait(lock, [this, seen_generation] { return !m_running || m_generation != seen_generation; });
+
+            if (!m_running)
+            {
+                return;
+            }
+
+            seen_generation = m_generation;
+        }
+
+        this->work(worker);
+    }
+}
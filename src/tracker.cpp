@@ -0,0 +1,353 @@
+#include "tracker.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+tracker::tracker(radar_config* radar_config) : m_radar_config(radar_config)
+{
+    // Roughly five degrees for a two antenna phase comparison
+    m_angle_var = 0.0076f;
+
+    m_range_accel_var = 1.0f;
+    m_angle_accel_var = 0.25f;
+
+    this->update_config();
+    this->reset();
+}
+
+void tracker::update_config()
+{
+    device_metrics_t* metrics = m_radar_config->get_device_metrics();
+
+    m_range_var = 0.25f * metrics->m_range_resolution * metrics->m_range_resolution;
+    m_speed_var = metrics->m_speed_resolution * metrics->m_speed_resolution;
+}
+
+tracker::~tracker()
+{
+    //dtor
+}
+
+void tracker::predict(track_t* track, float dt)
+{
+    float dt2 = dt * dt;
+    float dt3 = dt2 * dt;
+    float dt4 = dt3 * dt;
+
+    float* state[2] = {track->range_state, track->angle_state};
+    float (*cov[2])[2] = {track->range_cov, track->angle_cov};
+    float accel_var[2] = {m_range_accel_var, m_angle_accel_var};
+
+    for (int i = 0; i < 2; ++i)
+    {
+        float* x = state[i];
+        float (*p)[2] = cov[i];
+
+        x[0] += dt * x[1];
+
+        // P = F P F' + Q with F = [1 dt; 0 1] and white acceleration noise
+        float p00 = p[0][0] + dt * (p[0][1] + p[1][0]) + dt2 * p[1][1] + 0.25f * dt4 * accel_var[i];
+        float p01 = p[0][1] + dt * p[1][1] + 0.5f * dt3 * accel_var[i];
+        float p11 = p[1][1] + dt2 * accel_var[i];
+
+        p[0][0] = p00;
+        p[0][1] = p01;
+        p[1][0] = p01;
+        p[1][1] = p11;
+    }
+}
+
+float tracker::distance(const track_t* track, const detection_t* detection)
+{
+    // Range filter measures both states, S = P + R
+    float s00 = track->range_cov[0][0] + m_range_var;
+    float s01 = track->range_cov[0][1];
+    float s11 = track->range_cov[1][1] + m_speed_var;
+    float det = s00 * s11 - s01 * s01;
+
+    float y0 = detection->range - track->range_state[0];
+    float y1 = detection->speed - track->range_state[1];
+
+    float range_distance = (s11 * y0 * y0 - 2.0f * s01 * y0 * y1 + s00 * y1 * y1) / det;
+
+    // Angle filter measures the angle only, S = P00 + R
+    float ya = detection->angle - track->angle_state[0];
+    float angle_distance = ya * ya / (track->angle_cov[0][0] + m_angle_var);
+
+    return range_distance + angle_distance;
+}
+
+void tracker::correct(track_t* track, const detection_t* detection)
+{
+    float (*p)[2] = track->range_cov;
+
+    float s00 = p[0][0] + m_range_var;
+    float s01 = p[0][1];
+    float s11 = p[1][1] + m_speed_var;
+    float det = s00 * s11 - s01 * s01;
+
+    float i00 = s11 / det;
+    float i01 = -s01 / det;
+    float i11 = s00 / det;
+
+    // K = P S^-1
+    float k00 = p[0][0] * i00 + p[0][1] * i01;
+    float k01 = p[0][0] * i01 + p[0][1] * i11;
+    float k10 = p[1][0] * i00 + p[1][1] * i01;
+    float k11 = p[1][0] * i01 + p[1][1] * i11;
+
+    float y0 = detection->range - track->range_state[0];
+    float y1 = detection->speed - track->range_state[1];
+
+    track->range_state[0] += k00 * y0 + k01 * y1;
+    track->range_state[1] += k10 * y0 + k11 * y1;
+
+    // P = (I - K) P
+    float p00 = (1.0f - k00) * p[0][0] - k01 * p[1][0];
+    float p01 = (1.0f - k00) * p[0][1] - k01 * p[1][1];
+    float p11 = -k10 * p[0][1] + (1.0f - k11) * p[1][1];
+
+    p[0][0] = p00;
+    p[0][1] = p01;
+    p[1][0] = p01;
+    p[1][1] = p11;
+
+    float (*a)[2] = track->angle_cov;
+
+    float sa = a[0][0] + m_angle_var;
+    float ka0 = a[0][0] / sa;
+    float ka1 = a[1][0] / sa;
+
+    float ya = detection->angle - track->angle_state[0];
+
+    track->angle_state[0] += ka0 * ya;
+    track->angle_state[1] += ka1 * ya;
+
+    float a00 = (1.0f - ka0) * a[0][0];
+    float a01 = (1.0f - ka0) * a[0][1];
+    float a11 = a[1][1] - ka1 * a[0][1];
+
+    a[0][0] = a00;
+    a[0][1] = a01;
+    a[1][0] = a01;
+    a[1][1] = a11;
+}
+
+void tracker::birth(const detection_t* detection)
+{
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS; ++i)
+    {
+        track_t* track = &m_tracks[i];
+
+        if (track->active)
+        {
+            continue;
+        }
+
+        track->id = m_next_id++;
+
+        track->range_state[0] = detection->range;
+        track->range_state[1] = detection->speed;
+        track->range_cov[0][0] = m_range_var;
+        track->range_cov[0][1] = 0.0f;
+        track->range_cov[1][0] = 0.0f;
+        track->range_cov[1][1] = m_speed_var;
+
+        // Angular rate is not measured, start it wide open
+        track->angle_state[0] = detection->angle;
+        track->angle_state[1] = 0.0f;
+        track->angle_cov[0][0] = m_angle_var;
+        track->angle_cov[0][1] = 0.0f;
+        track->angle_cov[1][0] = 0.0f;
+        track->angle_cov[1][1] = 1.0f;
+
+        track->hits = 1;
+        track->misses = 0;
+        track->confirmed = false;
+        track->active = true;
+
+        return;
+    }
+
+    // Storage is full, the detection is dropped
+}
+
+void tracker::update(const detection_t* detections, uint32_t num_detections, float dt)
+{
+    num_detections = std::min(num_detections, (uint32_t) TRACKER_MAX_DETECTIONS);
+
+    uint32_t num_pairs = 0;
+
+    for (uint32_t t = 0; t < TRACKER_MAX_TRACKS; ++t)
+    {
+        m_track_used[t] = false;
+
+        if (!m_tracks[t].active)
+        {
+            continue;
+        }
+
+        this->predict(&m_tracks[t], dt);
+
+        for (uint32_t d = 0; d < num_detections; ++d)
+        {
+            float dist = this->distance(&m_tracks[t], &detections[d]);
+
+            if (dist < TRACKER_GATE)
+            {
+                m_pairs[num_pairs].distance = dist;
+                m_pairs[num_pairs].track = t;
+                m_pairs[num_pairs].detection = d;
+                ++num_pairs;
+            }
+        }
+    }
+
+    for (uint32_t d = 0; d < num_detections; ++d)
+    {
+        m_detection_used[d] = false;
+    }
+
+    // Global nearest neighbour, closest gated pairs are taken first
+    std::sort(m_pairs, m_pairs + num_pairs, [](const association_t& a, const association_t& b) { return a.distance < b.distance; });
+
+    for (uint32_t i = 0; i < num_pairs; ++i)
+    {
+        association_t* pair = &m_pairs[i];
+
+        if (m_track_used[pair->track] || m_detection_used[pair->detection])
+        {
+            continue;
+        }
+
+        m_track_used[pair->track] = true;
+        m_detection_used[pair->detection] = true;
+
+        track_t* track = &m_tracks[pair->track];
+
+        this->correct(track, &detections[pair->detection]);
+
+        track->hits += 1;
+        track->misses = 0;
+
+        if (track->hits >= TRACKER_CONFIRM_HITS)
+        {
+            track->confirmed = true;
+        }
+    }
+
+    for (uint32_t t = 0; t < TRACKER_MAX_TRACKS; ++t)
+    {
+        track_t* track = &m_tracks[t];
+
+        if (!track->active || m_track_used[t])
+        {
+            continue;
+        }
+
+        track->misses += 1;
+
+        if (!track->confirmed || track->misses >= TRACKER_MAX_MISSES)
+        {
+            track->active = false;
+        }
+    }
+
+    for (uint32_t d = 0; d < num_detections; ++d)
+    {
+        if (!m_detection_used[d])
+        {
+            this->birth(&detections[d]);
+        }
+    }
+}
+
+void tracker::reset()
+{
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS; ++i)
+    {
+        m_tracks[i].active = false;
+    }
+}
+
+uint32_t tracker::get_num_confirmed()
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS; ++i)
+    {
+        if (m_tracks[i].active && m_tracks[i].confirmed)
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+uint32_t tracker::get_confirmed(float* rows, uint32_t max_tracks)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS && count < max_tracks; ++i)
+    {
+        track_t* track = &m_tracks[i];
+
+        if (!track->active || !track->confirmed)
+        {
+            continue;
+        }
+
+        float* row = rows + 4 * count++;
+        row[0] = (float) track->id;
+        row[1] = track->range_state[0];
+        row[2] = track->range_state[1];
+        row[3] = track->angle_state[0];
+    }
+
+    return count;
+}
+
+json tracker::create_json()
+{
+    json tracks = json::array();
+
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS; ++i)
+    {
+        track_t* track = &m_tracks[i];
+
+        if (!track->active || !track->confirmed)
+        {
+            continue;
+        }
+
+        tracks.push_back({track->id, track->range_state[0], track->range_state[1], track->angle_state[0]});
+    }
+
+    return tracks;
+}
+
+void tracker::write_json(json_writer* writer)
+{
+    writer->begin_array();
+
+    for (uint32_t i = 0; i < TRACKER_MAX_TRACKS; ++i)
+    {
+        track_t* track = &m_tracks[i];
+
+        if (!track->active || !track->confirmed)
+        {
+            continue;
+        }
+
+        writer->begin_array();
+        writer->value(track->id);
+        writer->value(track->range_state[0]);
+        writer->value(track->range_state[1]);
+        writer->value(track->angle_state[0]);
+        writer->end_array();
+    }
+
+    writer->end_array();
+}
@@ -0,0 +1,228 @@
+#include "udp_reassembler.hpp"
+
+#include <string.h>
+
+udp_reassembler::udp_reassembler()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    for (uint32_t i = 0; i < UDP_REASSEMBLER_NUM_SLOTS; ++i)
+    {
+        m_slots[i].used = false;
+    }
+}
+
+udp_reassembler::~udp_reassembler()
+{
+    //dtor
+}
+
+udp_reassembler::slot_t* udp_reassembler::find_slot(uint32_t message)
+{
+    for (uint32_t i = 0; i < UDP_REASSEMBLER_NUM_SLOTS; ++i)
+    {
+        if (m_slots[i].used && m_slots[i].message == message)
+        {
+            return &m_slots[i];
+        }
+    }
+
+    return nullptr;
+}
+
+udp_reassembler::slot_t* udp_reassembler::claim_slot()
+{
+    slot_t* oldest = nullptr;
+
+    for (uint32_t i = 0; i < UDP_REASSEMBLER_NUM_SLOTS; ++i)
+    {
+        if (!m_slots[i].used)
+        {
+            return &m_slots[i];
+        }
+
+        if (oldest == nullptr || (int32_t) (m_slots[i].message - oldest->message) < 0)
+        {
+            oldest = &m_slots[i];
+        }
+    }
+
+    // Every slot is busy, the oldest message isn't going to make it any more
+    ++m_stats.incomplete_messages;
+    this->mark_done(oldest->message);
+    this->release(oldest);
+
+    return oldest;
+}
+
+void udp_reassembler::release(slot_t* slot)
+{
+    slot->used = false;
+}
+
+void udp_reassembler::advance(uint32_t message)
+{
+    uint32_t ahead = message - m_newest;
+
+    // What leaves the window without a fragment seen is lost, the ones skipped entirely included
+    for (uint32_t i = ahead < UDP_REASSEMBLER_WINDOW ? UDP_REASSEMBLER_WINDOW - ahead : 0; i < UDP_REASSEMBLER_WINDOW; ++i)
+    {
+        if (!(m_done & (1u << i)) && this->find_slot(m_newest - i) == nullptr)
+        {
+            ++m_stats.lost_messages;
+        }
+    }
+
+    if (ahead > UDP_REASSEMBLER_WINDOW)
+    {
+        m_stats.lost_messages += ahead - UDP_REASSEMBLER_WINDOW;
+    }
+
+    m_done = ahead < UDP_REASSEMBLER_WINDOW ? m_done << ahead : 0;
+    m_newest = message;
+}
+
+void udp_reassembler::mark_done(uint32_t message)
+{
+    uint32_t behind = m_newest - message;
+
+    if (behind < UDP_REASSEMBLER_WINDOW)
+    {
+        m_done |= 1u << behind;
+    }
+}
+
+bool udp_reassembler::is_done(uint32_t message)
+{
+    uint32_t behind = m_newest - message;
+
+    // Out of the window counts as given up on
+    return behind >= UDP_REASSEMBLER_WINDOW || (m_done & (1u << behind));
+}
+
+bool udp_reassembler::add(const uint8_t* datagram, size_t length)
+{
+    ++m_stats.datagrams;
+    m_stats.bytes += length;
+
+    if (m_complete != nullptr)
+    {
+        this->release(m_complete);
+        m_complete = nullptr;
+    }
+
+    udp_fragment_header_t header;
+
+    if (length < sizeof(header))
+    {
+        ++m_stats.invalid_datagrams;
+        return false;
+    }
+
+    memcpy(&header, datagram, sizeof(header));
+
+    const uint8_t* payload = datagram + sizeof(header);
+    size_t payload_length = length - sizeof(header);
+
+    if (header.magic != UDP_FRAGMENT_MAGIC || header.fragment >= header.num_fragments ||
+        (uint64_t) header.offset + payload_length > header.message_length)
+    {
+        ++m_stats.invalid_datagrams;
+        return false;
+    }
+
+    slot_t* slot = this->find_slot(header.message);
+
+    if (slot == nullptr)
+    {
+        int32_t ahead = (int32_t) (header.message - m_newest);
+
+        if (m_started && ahead < -UDP_REASSEMBLER_RESTART_JUMP)
+        {
+            // Whatever was in flight belongs to the sender that went away
+            for (uint32_t i = 0; i < UDP_REASSEMBLER_NUM_SLOTS; ++i)
+            {
+                if (m_slots[i].used)
+                {
+                    ++m_stats.incomplete_messages;
+                    this->release(&m_slots[i]);
+                }
+            }
+
+            ++m_stats.restarts;
+            m_started = false;
+        }
+
+        if (!m_started)
+        {
+            // Nothing before the first message is waited for
+            m_started = true;
+            m_newest = header.message;
+            m_done = ~1u;
+        }
+        else if (ahead > 0)
+        {
+            this->advance(header.message);
+        }
+        else if (this->is_done(header.message))
+        {
+            ++m_stats.late_fragments;
+            return false;
+        }
+
+        slot = this->claim_slot();
+        slot->used = true;
+        slot->message = header.message;
+        slot->length = header.message_length;
+        slot->num_fragments = header.num_fragments;
+        slot->received = 0;
+        slot->data.resize(header.message_length);
+        slot->have.assign(header.num_fragments, false);
+    }
+    else if (slot->length != header.message_length || slot->num_fragments != header.num_fragments)
+    {
+        ++m_stats.invalid_datagrams;
+        return false;
+    }
+
+    if (slot->have[header.fragment])
+    {
+        ++m_stats.duplicate_fragments;
+        return false;
+    }
+
+    memcpy(slot->data.data() + header.offset, payload, payload_length);
+    slot->have[header.fragment] = true;
+    ++slot->received;
+
+    if (slot->received < slot->num_fragments)
+    {
+        return false;
+    }
+
+    ++m_stats.messages;
+    this->mark_done(slot->message);
+    m_complete = slot;
+
+    return true;
+}
+
+const uint8_t* udp_reassembler::get_message()
+{
+    return m_complete != nullptr ? m_complete->data.data() : nullptr;
+}
+
+size_t udp_reassembler::get_message_length()
+{
+    return m_complete != nullptr ? m_complete->length : 0;
+}
+
+uint32_t udp_reassembler::get_message_sequence()
+{
+    return m_complete != nullptr ? m_complete->message : 0;
+}
+
+udp_reassembler_stats_t udp_reassembler::get_stats()
+{
+    return m_stats;
+}
@@ -0,0 +1,140 @@
+#include "udp_streamer.hpp"
+
+#include <algorithm>
+
+using boost::asio::ip::udp;
+
+// Room for a few full frames, a burst of datagrams shouldn't overflow it
+#define UDP_STREAMER_SEND_BUFFER_BYTES (1024 * 1024)
+
+udp_streamer::udp_streamer(uint32_t mtu, uint8_t multicast_ttl) : m_multicast_ttl(multicast_ttl),
+                                                                  m_socket(m_io_service)
+{
+    m_payload_size = mtu - UDP_IP_OVERHEAD - sizeof(udp_fragment_header_t);
+}
+
+udp_streamer::~udp_streamer()
+{
+    boost::system::error_code error;
+    m_socket.close(error);
+}
+
+bool udp_streamer::open(const std::string& address, uint16_t port, std::string* error)
+{
+    boost::system::error_code ec;
+
+    m_endpoint = udp::endpoint(boost::asio::ip::address::from_string(address, ec), port);
+
+    if (!ec)
+    {
+        m_socket.open(m_endpoint.protocol(), ec);
+    }
+
+    if (ec)
+    {
+        *error = ec.message();
+        return false;
+    }
+
+    if (this->is_multicast())
+    {
+        m_socket.set_option(boost::asio::ip::multicast::hops(m_multicast_ttl), ec);
+        m_socket.set_option(boost::asio::ip::multicast::enable_loopback(true), ec);
+    }
+
+    m_socket.set_option(boost::asio::socket_base::send_buffer_size(UDP_STREAMER_SEND_BUFFER_BYTES), ec);
+
+    // A full socket buffer drops the message instead of stalling acquisition
+    m_socket.non_blocking(true, ec);
+
+    return true;
+}
+
+bool udp_streamer::is_multicast()
+{
+    return m_endpoint.address().is_multicast();
+}
+
+void udp_streamer::send(const std::vector<boost::asio::const_buffer>& buffers, bool droppable)
+{
+    (void) droppable;
+
+    size_t length = boost::asio::buffer_size(buffers);
+
+    m_header.magic = UDP_FRAGMENT_MAGIC;
+    m_header.message = m_message++;
+    m_header.message_length = (uint32_t) length;
+    m_header.num_fragments = (uint16_t) (length == 0 ? 1 : (length + m_payload_size - 1) / m_payload_size);
+
+    // Position in the message buffers
+    size_t buffer_index = 0;
+    size_t buffer_offset = 0;
+
+    for (uint32_t fragment = 0; fragment < m_header.num_fragments; ++fragment)
+    {
+        size_t offset = (size_t) fragment * m_payload_size;
+        size_t remaining = std::min((size_t) m_payload_size, length - offset);
+
+        m_header.fragment = (uint16_t) fragment;
+        m_header.offset = (uint32_t) offset;
+
+        m_datagram.clear();
+        m_datagram.push_back(boost::asio::buffer(&m_header, sizeof(m_header)));
+
+        // The payload is picked out of the message buffers where they are
+        while (remaining > 0)
+        {
+            const boost::asio::const_buffer& buffer = buffers[buffer_index];
+            size_t take = std::min(buffer.size() - buffer_offset, remaining);
+
+            if (take > 0)
+            {
+                m_datagram.push_back(boost::asio::const_buffer((const uint8_t*) buffer.data() + buffer_offset, take));
+            }
+
+            remaining -= take;
+            buffer_offset += take;
+
+            if (buffer_offset == buffer.size())
+            {
+                ++buffer_index;
+                buffer_offset = 0;
+            }
+        }
+
+        boost::system::error_code error;
+        size_t sent = m_socket.send_to(m_datagram, m_endpoint, 0, error);
+
+        if (error)
+        {
+            // The rest of the message is of no use to anybody once a fragment is missing
+            m_dropped_bytes += length - offset;
+            ++m_dropped_messages;
+            return;
+        }
+
+        m_sent_bytes += sent;
+    }
+}
+
+bool udp_streamer::failed()
+{
+    return false;
+}
+
+std::string udp_streamer::get_error()
+{
+    return std::string();
+}
+
+packet_sink_stats_t udp_streamer::get_stats()
+{
+    packet_sink_stats_t stats;
+    stats.queued_bytes = 0;
+    stats.sent_bytes = m_sent_bytes;
+    stats.dropped_bytes = m_dropped_bytes;
+    stats.dropped_messages = m_dropped_messages;
+    stats.reconnects = 0;
+
+    return stats;
+}
@@ -0,0 +1,238 @@
+#include "vibration_estimator.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+vibration_estimator::vibration_estimator(uint32_t center_frequency_khz)
+{
+    const double c0 = 299792458.0;
+    m_wavelength_m = c0 / (1000.0 * center_frequency_khz);
+}
+
+vibration_estimator::~vibration_estimator()
+{
+    //dtor
+}
+
+bool vibration_estimator::estimate(const float* real, const float* imag, size_t bin_stride, uint32_t num_bins,
+                                   uint32_t num_points, float frame_rate, vibration_t* result)
+{
+    if (num_bins == 0 || num_points < VIBRATION_MIN_POINTS || !(frame_rate > 0.0f))
+    {
+        return false;
+    }
+
+    if (num_points > VIBRATION_MAX_POINTS)
+    {
+        real += num_points - VIBRATION_MAX_POINTS;
+        imag += num_points - VIBRATION_MAX_POINTS;
+        num_points = VIBRATION_MAX_POINTS;
+    }
+
+    // The bin moving the most has the most energy around its mean
+    uint32_t best_bin = 0;
+    double best_energy = -1.0;
+
+    for (uint32_t bin = 0; bin < num_bins; ++bin)
+    {
+        const float* bin_real = real + bin * bin_stride;
+        const float* bin_imag = imag + bin * bin_stride;
+
+        double mean_real = 0.0;
+        double mean_imag = 0.0;
+        for (uint32_t i = 0; i < num_points; ++i)
+        {
+            mean_real += bin_real[i];
+            mean_imag += bin_imag[i];
+        }
+        mean_real /= num_points;
+        mean_imag /= num_points;
+
+        double energy = 0.0;
+        for (uint32_t i = 0; i < num_points; ++i)
+        {
+            double dr = bin_real[i] - mean_real;
+            double di = bin_imag[i] - mean_imag;
+            energy += dr * dr + di * di;
+        }
+
+        if (energy > best_energy)
+        {
+            best_bin = bin;
+            best_energy = energy;
+        }
+    }
+
+    double centre_real;
+    double centre_imag;
+    this->fit_centre(real + best_bin * bin_stride, imag + best_bin * bin_stride, num_points, &centre_real, &centre_imag);
+
+    // Two way path, a full turn of phase is half a wavelength of movement
+    const double metres_per_radian = m_wavelength_m / (4.0 * M_PI);
+
+    const float* bin_real = real + best_bin * bin_stride;
+    const float* bin_imag = imag + best_bin * bin_stride;
+
+    m_displacement.resize(num_points);
+
+    double previous = 0.0;
+    double unwrapped = 0.0;
+    double mean = 0.0;
+    for (uint32_t i = 0; i < num_points; ++i)
+    {
+        double phase = atan2(bin_imag[i] - centre_imag, bin_real[i] - centre_real);
+
+        double step = phase - previous;
+        step -= 2.0 * M_PI * floor((step + M_PI) / (2.0 * M_PI));
+
+        unwrapped = i == 0 ? phase : unwrapped + step;
+        previous = phase;
+
+        m_displacement[i] = unwrapped * metres_per_radian;
+        mean += m_displacement[i];
+    }
+    mean /= num_points;
+
+    double window_sum = 0.0;
+    for (uint32_t i = 0; i < num_points; ++i)
+    {
+        double window = 0.5 - 0.5 * cos(2.0 * M_PI * i / (num_points - 1));
+
+        m_displacement[i] = (m_displacement[i] - mean) * window;
+        window_sum += window;
+    }
+
+    uint32_t first_line = std::max(1u, (uint32_t) ceil(VIBRATION_MIN_FREQUENCY_HZ * num_points / frame_rate));
+    uint32_t last_line = num_points / 2;
+
+    if (first_line + 2 > last_line)
+    {
+        return false;
+    }
+
+    m_power.assign(last_line + 1, 0.0);
+
+    uint32_t peak = first_line;
+    for (uint32_t k = first_line; k <= last_line; ++k)
+    {
+        // Twiddle by rotation, double keeps the drift far below what a float series holds
+        double rotate_real = cos(2.0 * M_PI * k / num_points);
+        double rotate_imag = -sin(2.0 * M_PI * k / num_points);
+        double twiddle_real = 1.0;
+        double twiddle_imag = 0.0;
+
+        double sum_real = 0.0;
+        double sum_imag = 0.0;
+        for (uint32_t i = 0; i < num_points; ++i)
+        {
+            sum_real += m_displacement[i] * twiddle_real;
+            sum_imag += m_displacement[i] * twiddle_imag;
+
+            double next_real = twiddle_real * rotate_real - twiddle_imag * rotate_imag;
+            twiddle_imag = twiddle_real * rotate_imag + twiddle_imag * rotate_real;
+            twiddle_real = next_real;
+        }
+
+        m_power[k] = sum_real * sum_real + sum_imag * sum_imag;
+
+        if (m_power[k] > m_power[peak])
+        {
+            peak = k;
+        }
+    }
+
+    // Between two lines, parabola through the magnitudes of the peak and its neighbours
+    double offset = 0.0;
+    if (peak > first_line && peak < last_line)
+    {
+        double a = sqrt(m_power[peak - 1]);
+        double b = sqrt(m_power[peak]);
+        double c = sqrt(m_power[peak + 1]);
+        double curvature = a - 2.0 * b + c;
+
+        if (curvature < 0.0)
+        {
+            offset = 0.5 * (a - c) / curvature;
+        }
+    }
+
+    // Hann main lobe, what a line that far off the bin centre loses
+    double gain = 1.0;
+    if (offset != 0.0)
+    {
+        gain = sin(M_PI * offset) / (M_PI * offset) / (1.0 - offset * offset);
+    }
+
+    // Noise floor without the peak and the two lines it leaks into most
+    std::vector<double> floor_lines;
+    for (uint32_t k = first_line; k <= last_line; ++k)
+    {
+        if (k + 1 < peak || k > peak + 1)
+        {
+            floor_lines.push_back(m_power[k]);
+        }
+    }
+
+    double noise = 0.0;
+    if (!floor_lines.empty())
+    {
+        std::nth_element(floor_lines.begin(), floor_lines.begin() + floor_lines.size() / 2, floor_lines.end());
+        noise = floor_lines[floor_lines.size() / 2];
+    }
+
+    result->bin_index = best_bin;
+    result->amplitude_m = (float) (2.0 * sqrt(m_power[peak]) / window_sum / gain);
+    result->frequency_hz = (float) ((peak + offset) * frame_rate / num_points);
+    result->snr_db = noise > 0.0 ? (float) (10.0 * log10(m_power[peak] / noise)) : INFINITY;
+
+    return true;
+}
+
+void vibration_estimator::fit_centre(const float* real, const float* imag, uint32_t num_points, double* centre_real, double* centre_imag)
+{
+    double mean_real = 0.0;
+    double mean_imag = 0.0;
+    for (uint32_t i = 0; i < num_points; ++i)
+    {
+        mean_real += real[i];
+        mean_imag += imag[i];
+    }
+    mean_real /= num_points;
+    mean_imag /= num_points;
+
+    // Least squares circle (Kasa) in coordinates around the mean, which keeps the sums well scaled
+    double suu = 0.0, svv = 0.0, suv = 0.0;
+    double suuu = 0.0, svvv = 0.0, suvv = 0.0, svuu = 0.0;
+
+    for (uint32_t i = 0; i < num_points; ++i)
+    {
+        double u = real[i] - mean_real;
+        double v = imag[i] - mean_imag;
+
+        suu += u * u;
+        svv += v * v;
+        suv += u * v;
+        suuu += u * u * u;
+        svvv += v * v * v;
+        suvv += u * v * v;
+        svuu += v * u * u;
+    }
+
+    double determinant = suu * svv - suv * suv;
+
+    *centre_real = mean_real;
+    *centre_imag = mean_imag;
+
+    // Points on a line have no centre, the mean is as good as it gets
+    if (determinant <= 1e-12 * suu * svv)
+    {
+        return;
+    }
+
+    double a = 0.5 * (suuu + suvv);
+    double b = 0.5 * (svvv + svuu);
+
+    *centre_real += (a * svv - b * suv) / determinant;
+    *centre_imag += (b * suu - a * suv) / determinant;
+}
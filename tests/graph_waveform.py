@@ -2,6 +2,9 @@ import matplotlib.pyplot as plt
 from scipy.signal import butter, lfilter
 
 import numpy as np
+import json
+import struct
+import sys
 
 plt.rcParams.update({'font.size': 10})
 
@@ -24,23 +27,62 @@ use_filter = False
 
 delta_bin = 8
 
-metrics = open("metrics.txt").read().splitlines()
-range_resolution = float(metrics[0].split(": ")[1])
-range_interest = float(metrics[1].split(": ")[1])
-bin_interest = float(metrics[2].split(": ")[1])
-x_vals = np.asarray(metrics[3].split(", "), dtype=np.float64, order='C')
-
-sample_rate = 1/(x_vals[1] - x_vals[0])
+def read_recording(path):
+    """Segments of a slow-time recording, see include/slow_time_recorder.hpp"""
+    data = open(path, "rb").read()
+    if data[0:4] != b"RDST":
+        raise ValueError(path + " is not a slow-time recording")
+
+    segments = []
+    offset = 8
+    while offset + 8 <= len(data):
+        chunk_type, length = struct.unpack_from("<II", data, offset)
+        offset += 8
+        if offset + length > len(data):
+            break  # Still being written
+        payload = data[offset:offset + length]
+        offset += length
+
+        if chunk_type == 1:
+            schema = json.loads(payload)
+            segments.append({"schema": schema, "timestamp_us": [], "real": [], "imag": [], "spectra": []})
+        elif chunk_type == 2:
+            num_rows = struct.unpack_from("<I", payload, 0)[0]
+            num_bins = segments[-1]["schema"]["num_bins"]
+            at = 8
+            segments[-1]["timestamp_us"].append(np.frombuffer(payload, np.uint64, num_rows, at))
+            at += 8 * num_rows + 4 * num_rows
+            for column in ("real", "imag"):
+                segments[-1][column].append(np.frombuffer(payload, np.float32, num_bins * num_rows, at).reshape(num_bins, num_rows))
+                at += 4 * num_bins * num_rows
+        elif chunk_type == 3:
+            num_points = struct.unpack_from("<I", payload, 12)[0]
+            num_bins = segments[-1]["schema"]["num_bins"]
+            segments[-1]["spectra"].append(np.frombuffer(payload, np.float32, num_bins * num_points, 16).reshape(num_bins, num_points))
+
+    for segment in segments:
+        if segment["timestamp_us"]:
+            segment["timestamp_us"] = np.concatenate(segment["timestamp_us"])
+            segment["real"] = np.concatenate(segment["real"], axis=1)
+            segment["imag"] = np.concatenate(segment["imag"], axis=1)
+
+    return segments
+
+
+segment = read_recording(sys.argv[1] if len(sys.argv) > 1 else "slow_time.rdst")[-1]
+schema = segment["schema"]
+
+range_resolution = schema["metrics"]["range_resolution"]
+x_vals = (segment["timestamp_us"] - segment["timestamp_us"][0]) / 1e6
+
+sample_rate = schema["metrics"]["frame_rate"]
 
 fig, plots = plt.subplots(int(delta_bin / 2), 2)
 
-data = open("data.txt").read().splitlines()
-i = 0
-graph_num = 0
-while (i < len(data)):
-    curr_bin = int(data[i].split(": ")[1])
-    real = np.asarray(data[i + 2].split(", "), dtype=np.float64, order='C')
-    imag = np.asarray(data[i + 4].split(", "), dtype=np.float64, order='C')
+for graph_num in range(min(delta_bin, schema["num_bins"])):
+    curr_bin = schema["first_bin"] + graph_num
+    real = segment["real"][graph_num].astype(np.float64)
+    imag = segment["imag"][graph_num].astype(np.float64)
 
     if (use_filter == True):
         real = butter_lowpass_filter(real, cutoff, sample_rate, order)
@@ -52,11 +94,5 @@ while (i < len(data)):
     #plots[graph_num, 1].set_title(str(curr_bin) + " imag", fontsize=20)
     #plots[graph_num, 1].plot(x_vals, real)
 
-    i += 5
-    graph_num += 1
-
-    if (graph_num >= delta_bin):
-        break
-
 plt.legend()
 plt.show()
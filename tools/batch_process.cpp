@@ -0,0 +1,495 @@
+#include "dsp.hpp"
+#include "legacy_capture.hpp"
+#include "radar_config.hpp"
+#include "replay_source.hpp"
+#include "slow_time_reader.hpp"
+#include "slow_time_recorder.hpp"
+#include "thread_pool.hpp"
+#include "vibration_estimator.hpp"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using namespace std;
+
+// The slow-time recording of a frame capture goes next to it, with this appended to its name
+#define BATCH_RECORDING_SUFFIX ".rdst"
+
+typedef enum
+{
+    CAPTURE_FRAMES,         // Raw frames, see frame_recorder
+    CAPTURE_RECORDING,      // Slow-time recording, see slow_time_recorder
+    CAPTURE_LEGACY          // metrics.txt / data.txt directory, see legacy_capture
+} capture_kind_t;
+
+static const char* capture_kind_names[] = {"frames", "recording", "legacy"};
+
+typedef struct
+{
+    string path;
+    capture_kind_t kind;
+
+    // Filled in by process_capture
+    string error;
+    uint32_t frames = 0;        // Frames replayed, rows for the other kinds
+    uint32_t rows = 0;          // Consecutive slow-time rows the estimate is based on
+    float range_m = 0.0f;
+    vibration_t vibration;
+    double runtime_ms = 0.0;
+} capture_t;
+
+// FFTW planning and the SDK handles a dsp is made of don't like being set up in parallel
+std::mutex dsp_setup_lock;
+
+bool is_directory(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool is_file(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+bool has_magic(const string& path, const char* magic)
+{
+    char start[4];
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool match = fread(start, 1, sizeof(start), file) == sizeof(start) && memcmp(start, magic, sizeof(start)) == 0;
+    fclose(file);
+
+    return match;
+}
+
+// Captures at or below path in name order. A directory holding a recording isn't read as legacy text.
+void find_captures(const string& path, vector<capture_t>* captures)
+{
+    if (!is_directory(path))
+    {
+        capture_t capture;
+        capture.path = path;
+
+        if (has_magic(path, FRAME_CAPTURE_MAGIC))
+        {
+            capture.kind = CAPTURE_FRAMES;
+            captures->push_back(capture);
+        }
+        else if (has_magic(path, SLOW_TIME_RECORDING_MAGIC))
+        {
+            capture.kind = CAPTURE_RECORDING;
+            captures->push_back(capture);
+        }
+        return;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+
+    vector<string> names;
+    for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        string name = entry->d_name;
+
+        if (name != "." && name != "..")
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+
+    vector<capture_t> found;
+    for (const string& name : names)
+    {
+        find_captures(path + "/" + name, &found);
+    }
+
+    // Recordings made from frame captures are made again rather than read
+    vector<capture_t> kept;
+    bool has_recording = false;
+
+    for (const capture_t& capture : found)
+    {
+        bool generated = false;
+        for (const capture_t& other : found)
+        {
+            generated = generated || (other.kind == CAPTURE_FRAMES && other.path + BATCH_RECORDING_SUFFIX == capture.path);
+        }
+
+        if (generated)
+        {
+            continue;
+        }
+
+        // Only a recording in this directory itself stands in for its text
+        has_recording = has_recording || (capture.kind == CAPTURE_RECORDING && capture.path.rfind('/') == path.size());
+
+        kept.push_back(capture);
+    }
+
+    if (!has_recording && is_file(path + "/" + LEGACY_CAPTURE_DATA_FILE) && is_file(path + "/" + LEGACY_CAPTURE_METRICS_FILE))
+    {
+        capture_t capture;
+        capture.path = path;
+        capture.kind = CAPTURE_LEGACY;
+        captures->push_back(capture);
+    }
+
+    captures->insert(captures->end(), kept.begin(), kept.end());
+}
+
+// Runs the dsp chain over a frame capture and records what its slow-time stage produces
+bool record_frames(radar_config base_config, const string& path, const string& recording_path, uint32_t* frames, string* error)
+{
+    frame_capture_header_t header;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    bool read = file != nullptr && fread(&header, sizeof(header), 1, file) == 1;
+    if (file != nullptr)
+    {
+        fclose(file);
+    }
+
+    if (!read)
+    {
+        *error = "can't read " + path;
+        return false;
+    }
+
+    // The capture knows the rate it was taken at, the config file can't
+    radar_config rc = base_config;
+    rc.set_frame_rate(header.frame_rate);
+
+    replay_source source(&rc);
+    if (!source.open(path, error))
+    {
+        return false;
+    }
+    source.set_paced(false);
+
+    // The recorder appends, a new run starts from scratch
+    remove(recording_path.c_str());
+
+    slow_time_recorder recorder;
+    if (!recorder.open(recording_path, error))
+    {
+        return false;
+    }
+
+    dsp* chain;
+    {
+        std::lock_guard<std::mutex> lock(dsp_setup_lock);
+
+        // Captures are spread over the cores, so every chain gets just one
+        chain = new dsp(&rc, 1);
+    }
+
+    if (chain->failed())
+    {
+        *error = "can't set up the dsp: " + chain->get_error();
+
+        std::lock_guard<std::mutex> lock(dsp_setup_lock);
+        delete chain;
+        return false;
+    }
+
+    chain->set_stages(DSP_STAGE_SLOW_TIME);
+    chain->write_slow_time_schema(&recorder);
+
+    double period_us = 1e6 / header.frame_rate;
+
+    uint32_t sequence = 0;
+    while (true)
+    {
+        ifx_Error_t ret = source.pull_frame();
+
+        if (source.finished())
+        {
+            break;
+        }
+
+        if (ret != IFX_OK)
+        {
+            continue;
+        }
+
+        chain->process(source.get_frame());
+        chain->write_slow_time(&recorder, sequence, (uint64_t) (sequence * period_us));
+
+        ++sequence;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dsp_setup_lock);
+        delete chain;
+    }
+
+    recorder.flush();
+
+    *frames = sequence;
+
+    return true;
+}
+
+// The longest stretch of rows without a gap, the dsp only records while presence is confirmed
+void find_longest_run(const slow_time_segment_t* segment, uint32_t* start, uint32_t* length)
+{
+    *start = 0;
+    *length = 0;
+
+    uint32_t run_start = 0;
+    for (uint32_t row = 1; row <= segment->num_rows; ++row)
+    {
+        if (row == segment->num_rows || segment->sequences[row] != segment->sequences[row - 1] + 1)
+        {
+            if (row - run_start > *length)
+            {
+                *start = run_start;
+                *length = row - run_start;
+            }
+            run_start = row;
+        }
+    }
+}
+
+void process_capture(radar_config* base_config, capture_t* capture)
+{
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    slow_time_reader reader;
+    slow_time_segment_t legacy_segment;
+    const slow_time_segment_t* segment = nullptr;
+
+    if (capture->kind == CAPTURE_LEGACY)
+    {
+        legacy_capture legacy;
+        if (!legacy.open(capture->path, &capture->error))
+        {
+            return;
+        }
+
+        // Passes one after the other, the same layout the reader gives
+        legacy_segment.metrics["range_resolution"] = legacy.get_range_resolution();
+        legacy_segment.metrics["frame_rate"] = legacy.get_frame_rate();
+        legacy_segment.first_bin = legacy.get_first_bin();
+        legacy_segment.num_bins = legacy.get_num_bins();
+        legacy_segment.num_points = legacy.get_num_points();
+        legacy_segment.num_rows = legacy.get_num_passes() * legacy.get_num_points();
+        legacy_segment.num_spectra = 0;
+
+        legacy_segment.sequences.resize(legacy_segment.num_rows);
+        for (uint32_t row = 0; row < legacy_segment.num_rows; ++row)
+        {
+            legacy_segment.sequences[row] = row;
+        }
+
+        for (uint32_t bin_index = 0; bin_index < legacy_segment.num_bins; ++bin_index)
+        {
+            for (uint32_t pass = 0; pass < legacy.get_num_passes(); ++pass)
+            {
+                legacy_segment.real.insert(legacy_segment.real.end(), legacy.get_real(pass, bin_index), legacy.get_real(pass, bin_index) + legacy_segment.num_points);
+                legacy_segment.imag.insert(legacy_segment.imag.end(), legacy.get_imag(pass, bin_index), legacy.get_imag(pass, bin_index) + legacy_segment.num_points);
+            }
+        }
+
+        segment = &legacy_segment;
+    }
+    else
+    {
+        string recording_path = capture->path;
+
+        if (capture->kind == CAPTURE_FRAMES)
+        {
+            recording_path += BATCH_RECORDING_SUFFIX;
+
+            if (!record_frames(*base_config, capture->path, recording_path, &capture->frames, &capture->error))
+            {
+                return;
+            }
+        }
+
+        if (!reader.open(recording_path, &capture->error))
+        {
+            return;
+        }
+
+        segment = reader.get_longest_segment();
+    }
+
+    if (segment == nullptr)
+    {
+        capture->error = "no slow-time rows, presence was never confirmed";
+        return;
+    }
+
+    if (capture->kind != CAPTURE_FRAMES)
+    {
+        capture->frames = segment->num_rows;
+    }
+
+    uint32_t start;
+    find_longest_run(segment, &start, &capture->rows);
+
+    vibration_estimator estimator(segment->metrics.value("center_frequency_khz", (uint32_t) VIBRATION_DEFAULT_CENTER_FREQUENCY_KHZ));
+
+    if (!estimator.estimate(segment->real.data() + start, segment->imag.data() + start, segment->num_rows, segment->num_bins,
+                            capture->rows, segment->metrics.value("frame_rate", 0.0f), &capture->vibration))
+    {
+        capture->error = "too few consecutive rows for a spectrum";
+        return;
+    }
+
+    capture->range_m = (segment->first_bin + capture->vibration.bin_index) * segment->metrics.value("range_resolution", 0.0f);
+
+    capture->runtime_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> inputs;
+    string summary_path;
+    string config_path;
+    uint32_t num_threads;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("input,i", po::value<vector<string>>(&inputs), "capture, recording, or a directory to search for them")
+        ("summary,o", po::value<string>(&summary_path)->default_value("summary.csv"), "per capture results as CSV")
+        ("config,c", po::value<string>(&config_path)->default_value(RADAR_CONFIG_DEFAULT_PATH),
+            "config the frame captures were taken with, the frame rate comes from the capture")
+        ("threads,t", po::value<uint32_t>(&num_threads)->default_value(0), "captures processed at once, 0 for one per core");
+
+    po::positional_options_description positional;
+    positional.add("input", -1);
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (vm.count("help") || inputs.empty())
+    {
+        cout << "Usage: ./radar_batch <directory>... [options]" << endl
+             << "Estimates the vibration in every capture found. Raw frame captures run through the dsp chain" << endl
+             << "and leave their slow-time recording next to them as <capture>" << BATCH_RECORDING_SUFFIX << ", slow-time" << endl
+             << "recordings and legacy metrics.txt / data.txt directories are analysed as they are." << endl
+             << options << endl;
+        return vm.count("help") ? 0 : 1;
+    }
+
+    radar_config rc;
+
+    string config_error;
+    if (!rc.load_file(config_path, &config_error))
+    {
+        cerr << "Using default configuration, " << config_path << ": " << config_error << endl;
+    }
+
+    vector<capture_t> captures;
+    for (const string& input : inputs)
+    {
+        find_captures(input, &captures);
+    }
+
+    if (captures.empty())
+    {
+        cerr << "No captures found" << endl;
+        return 1;
+    }
+
+    thread_pool pool(num_threads);
+
+    cout << "Processing " << captures.size() << " captures on " << pool.get_num_threads() << " threads" << endl;
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    pool.run_batch((uint32_t) captures.size(), [&rc, &captures](uint32_t index) { process_capture(&rc, &captures[index]); });
+
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    FILE* summary = fopen(summary_path.c_str(), "w");
+    if (summary == nullptr)
+    {
+        cerr << "Can't write " << summary_path << endl;
+    }
+    else
+    {
+        fprintf(summary, "capture,kind,frames,rows,range_m,amplitude_um,frequency_hz,snr_db,runtime_ms,error\n");
+    }
+
+    printf("%-40s %-9s %7s %7s %8s %12s %12s %8s %10s\n", "capture", "kind", "frames", "rows", "range_m", "amplitude_um", "frequency_hz", "snr_db", "runtime_ms");
+
+    uint32_t failed = 0;
+    double busy_ms = 0.0;
+
+    for (const capture_t& capture : captures)
+    {
+        const char* kind = capture_kind_names[capture.kind];
+
+        if (!capture.error.empty())
+        {
+            ++failed;
+            printf("%-40s %-9s %s\n", capture.path.c_str(), kind, capture.error.c_str());
+
+            if (summary != nullptr)
+            {
+                fprintf(summary, "\"%s\",%s,%u,%u,,,,,,\"%s\"\n", capture.path.c_str(), kind, capture.frames, capture.rows, capture.error.c_str());
+            }
+            continue;
+        }
+
+        busy_ms += capture.runtime_ms;
+
+        printf("%-40s %-9s %7u %7u %8.3f %12.2f %12.3f %8.1f %10.1f\n", capture.path.c_str(), kind, capture.frames, capture.rows,
+               capture.range_m, capture.vibration.amplitude_m * 1e6, capture.vibration.frequency_hz, capture.vibration.snr_db, capture.runtime_ms);
+
+        if (summary != nullptr)
+        {
+            fprintf(summary, "\"%s\",%s,%u,%u,%.4f,%.3f,%.4f,%.2f,%.2f,\n", capture.path.c_str(), kind, capture.frames, capture.rows,
+                    capture.range_m, capture.vibration.amplitude_m * 1e6, capture.vibration.frequency_hz, capture.vibration.snr_db, capture.runtime_ms);
+        }
+    }
+
+    if (summary != nullptr)
+    {
+        fclose(summary);
+    }
+
+    printf("%zu captures, %u failed, %.0f ms wall time for %.0f ms of work\n", captures.size(), failed, wall_ms, busy_ms);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include "payload_codec.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Slack for float rounding on top of the guaranteed bound
+#define CODEC_CHECK_SLACK_DB 1e-3f
+
+// Rows as in range_angle, by the range bins of conf/config.json
+#define CODEC_CHECK_MAP_ROWS 32
+#define CODEC_CHECK_MAP_COLUMNS 64
+
+mt19937 generator(1);
+
+// Exponential noise around noise_power with a few blobs on top, like a range-angle map of a room
+vector<float> create_map(uint32_t num_targets, float noise_power)
+{
+    exponential_distribution<float> noise(1.0f / noise_power);
+    uniform_real_distribution<float> position(0.0f, 1.0f);
+
+    vector<float> map(CODEC_CHECK_MAP_ROWS * CODEC_CHECK_MAP_COLUMNS);
+    for (float& value : map)
+    {
+        value = noise(generator);
+    }
+
+    for (uint32_t target = 0; target < num_targets; ++target)
+    {
+        float row = position(generator) * CODEC_CHECK_MAP_ROWS;
+        float column = position(generator) * CODEC_CHECK_MAP_COLUMNS;
+        float power = noise_power * powf(10.0f, 3.0f + 3.0f * position(generator));
+
+        for (uint32_t r = 0; r < CODEC_CHECK_MAP_ROWS; ++r)
+        {
+            for (uint32_t c = 0; c < CODEC_CHECK_MAP_COLUMNS; ++c)
+            {
+                float distance = (r - row) * (r - row) / 4.0f + (c - column) * (c - column);
+                map[r * CODEC_CHECK_MAP_COLUMNS + c] += power * expf(-distance);
+            }
+        }
+    }
+
+    return map;
+}
+
+// Flat at -50 dB with single bins at 0 dB. The spike is hundreds of levels off a block that is
+// otherwise zero deltas, so its residual only fits through the escape.
+vector<float> create_spikes(uint32_t count)
+{
+    vector<float> spectrum(count, -50.0f);
+    for (uint32_t i = 5; i < count; i += 37)
+    {
+        spectrum[i] = 0.0f;
+    }
+
+    return spectrum;
+}
+
+// Compresses values, decodes them again and compares against what the codec promises
+bool check(const string& name, payload_codec* codec, const vector<float>& values, bool in_db, double* ratio)
+{
+    const vector<uint8_t>& packed = codec->compress(values.data(), values.size(), in_db);
+
+    vector<float> decoded;
+    if (!payload_codec::decompress(packed.data(), packed.size(), &decoded) || decoded.size() != values.size())
+    {
+        cerr << name << ": doesn't decode" << endl;
+        return false;
+    }
+
+    payload_codec_header_t header;
+    memcpy(&header, packed.data(), sizeof(header));
+
+    const float bound = codec->get_error_bound_db();
+
+    if (header.max_error_db != bound)
+    {
+        cerr << name << ": header declares " << header.max_error_db << " dB instead of " << bound << " dB" << endl;
+        return false;
+    }
+
+    float worst = 0.0f;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        // Everything under the floor is sent as the floor
+        float original = max(in_db ? values[i] : 10.0f * log10f(values[i] + 1e-20f), header.floor_db);
+        float result = in_db ? decoded[i] : 10.0f * log10f(decoded[i]);
+
+        worst = max(worst, fabsf(result - original));
+    }
+
+    *ratio = packed.empty() ? 0.0 : (double) (values.size() * sizeof(float)) / packed.size();
+
+    cout << name << ": " << values.size() << " values in " << packed.size() << " bytes, " << *ratio << "x, worst error "
+         << worst << " of " << bound << " dB" << endl;
+
+    if (worst > bound + CODEC_CHECK_SLACK_DB)
+    {
+        cerr << name << ": error over the bound" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    const compression_t compressions[] = {COMPRESSION_DB8, COMPRESSION_DB16};
+    const float max_errors_db[] = {PAYLOAD_CODEC_DEFAULT_MAX_ERROR_DB, 1.0f};
+
+    bool ok = true;
+
+    for (compression_t compression : compressions)
+    {
+        for (float max_error_db : max_errors_db)
+        {
+            payload_codec codec(compression, max_error_db, PAYLOAD_CODEC_DEFAULT_DYNAMIC_RANGE_DB);
+
+            const string prefix = string(get_compression_name(compression)) + " at " + to_string(max_error_db).substr(0, 4) + " dB, ";
+            double ratio;
+            double sum = 0.0;
+
+            const uint32_t num_maps = 20;
+            for (uint32_t i = 0; i < num_maps; ++i)
+            {
+                ok = check(prefix + "map " + to_string(i), &codec, create_map(1 + i % 4, 1e-6f), false, &ratio) && ok;
+                sum += ratio;
+            }
+
+            cout << prefix << "maps on average " << sum / num_maps << "x" << endl;
+
+            ok = check(prefix + "noise", &codec, create_map(0, 1e-6f), false, &ratio) && ok;
+            ok = check(prefix + "escapes", &codec, create_spikes(1000), true, &ratio) && ok;
+
+            // Below the dynamic range, a partial last block, zeros and nothing at all
+            vector<float> deep = create_map(2, 1e-6f);
+            deep.resize(1000);
+            deep[17] = 0.0f;
+            deep[600] = 1e-30f;
+            ok = check(prefix + "floor", &codec, deep, false, &ratio) && ok;
+            ok = check(prefix + "empty", &codec, vector<float>(), false, &ratio) && ok;
+        }
+    }
+
+    // Truncated payloads are refused rather than read past their end
+    payload_codec codec(COMPRESSION_DB8, PAYLOAD_CODEC_DEFAULT_MAX_ERROR_DB, PAYLOAD_CODEC_DEFAULT_DYNAMIC_RANGE_DB);
+    vector<float> map = create_map(2, 1e-6f);
+    const vector<uint8_t>& packed = codec.compress(map.data(), map.size(), false);
+    vector<float> decoded;
+
+    for (size_t length = 0; length < packed.size(); length += 7)
+    {
+        if (payload_codec::decompress(packed.data(), length, &decoded))
+        {
+            cerr << "truncated to " << length << " of " << packed.size() << " bytes: decodes" << endl;
+            ok = false;
+        }
+    }
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include "legacy_capture.hpp"
+#include "slow_time_recorder.hpp"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using namespace std;
+
+bool is_directory(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool is_file(const string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+// Every directory below path with a data.txt, path itself included, in name order
+void find_captures(const string& path, vector<string>* captures)
+{
+    if (is_file(path + "/" + LEGACY_CAPTURE_DATA_FILE))
+    {
+        captures->push_back(path);
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+
+    vector<string> children;
+    for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        string name = entry->d_name;
+
+        if (name != "." && name != ".." && is_directory(path + "/" + name))
+        {
+            children.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(children.begin(), children.end());
+
+    for (const string& child : children)
+    {
+        find_captures(child, captures);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> inputs;
+    string output_name;
+    uint32_t chunk_rows;
+    bool check_only;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("input,i", po::value<vector<string>>(&inputs), "capture directory, or a directory to search for captures")
+        ("output,o", po::value<string>(&output_name)->default_value("slow_time.rdst"),
+            "recording written next to every data.txt, replacing an earlier conversion")
+        ("chunk-rows", po::value<uint32_t>(&chunk_rows)->default_value(512), "rows per chunk of the recording")
+        ("check", po::bool_switch(&check_only), "only parse and validate, write nothing");
+
+    po::positional_options_description positional;
+    positional.add("input", -1);
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (vm.count("help") || inputs.empty())
+    {
+        cout << "Usage: ./radar_convert_legacy <directory>... [options]" << endl
+             << "Converts the metrics.txt / data.txt captures dsp used to write into slow-time recordings." << endl
+             << options << endl;
+        return vm.count("help") ? 0 : 1;
+    }
+
+    if (chunk_rows == 0)
+    {
+        cerr << "--chunk-rows has to be at least 1" << endl;
+        return 1;
+    }
+
+    vector<string> captures;
+    for (const string& input : inputs)
+    {
+        find_captures(input, &captures);
+    }
+
+    if (captures.empty())
+    {
+        cerr << "No " << LEGACY_CAPTURE_DATA_FILE << " found" << endl;
+        return 1;
+    }
+
+    uint32_t failed = 0;
+    size_t text_bytes = 0;
+    double parse_seconds = 0.0;
+
+    for (const string& directory : captures)
+    {
+        legacy_capture capture;
+        string error;
+
+        std::chrono::steady_clock::time_point parse_start = std::chrono::steady_clock::now();
+        bool valid = capture.open(directory, &error);
+        parse_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count();
+
+        if (!valid)
+        {
+            cerr << error << endl;
+            ++failed;
+            continue;
+        }
+
+        text_bytes += capture.get_text_size();
+
+        cout << directory << ": " << capture.get_num_passes() << " x " << capture.get_num_bins() << " bins from "
+             << capture.get_first_bin() << ", " << capture.get_num_points() << " points at " << capture.get_frame_rate() << " Hz" << endl;
+
+        for (const string& warning : capture.get_warnings())
+        {
+            cout << "  warning: " << warning << endl;
+        }
+
+        if (check_only)
+        {
+            continue;
+        }
+
+        string path = directory + "/" + output_name;
+
+        // The recorder appends, a conversion starts from scratch
+        remove(path.c_str());
+
+        slow_time_recorder recorder(chunk_rows);
+        if (!recorder.open(path, &error))
+        {
+            cerr << error << endl;
+            ++failed;
+            continue;
+        }
+
+        capture.write_recording(&recorder);
+    }
+
+    cout << captures.size() - failed << " of " << captures.size() << " captures " << (check_only ? "valid" : "converted") << ", "
+         << text_bytes / 1e6 << " MB of text parsed at " << (parse_seconds > 0.0 ? text_bytes / 1e6 / parse_seconds : 0.0) << " MB/s" << endl;
+
+    return failed > 0 ? 1 : 0;
+}
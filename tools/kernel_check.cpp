@@ -0,0 +1,239 @@
+#include "dsp_kernel.hpp"
+
+#include <math.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define REAL 0
+#define IMAG 1
+
+// The mean scales by 1 / antennas where the reference divides, nothing else may round differently
+#define KERNEL_CHECK_TOLERANCE 1e-5f
+
+struct check_case_t
+{
+    uint32_t num_samples;
+    uint32_t num_chirps;
+    uint32_t num_antennas;
+    uint32_t full_bins;     // Columns of the range transform, range_fft_size / 2
+    bool specialised;
+};
+
+mt19937 generator(1);
+
+ifx_Float_t random_value()
+{
+    uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    return distribution(generator);
+}
+
+vector<ifx_Complex_t> random_complex(size_t size)
+{
+    vector<ifx_Complex_t> values(size);
+    for (ifx_Complex_t& value : values)
+    {
+        value.data[REAL] = random_value();
+        value.data[IMAG] = random_value();
+    }
+    return values;
+}
+
+bool same(const ifx_Complex_t& a, const ifx_Complex_t& b)
+{
+    return a.data[REAL] == b.data[REAL] && a.data[IMAG] == b.data[IMAG];
+}
+
+bool near(float a, float b)
+{
+    return fabsf(a - b) <= KERNEL_CHECK_TOLERANCE * (1.0f + fabsf(b));
+}
+
+// Runs every kernel of one build against the loops written out plainly, prints what differs
+bool check(const check_case_t& test)
+{
+    const string name = to_string(test.num_samples) + "x" + to_string(test.num_chirps) + "x" + to_string(test.num_antennas)
+                        + " over " + to_string(test.full_bins) + " bins";
+    bool ok = true;
+
+    dsp_kernel* kernel = create_dsp_kernel(test.num_samples, test.num_chirps, test.num_antennas);
+
+    if (kernel->is_specialised() != test.specialised)
+    {
+        cerr << name << ": expected the " << (test.specialised ? "specialised" : "generic") << " build" << endl;
+        ok = false;
+    }
+
+    // The detection zone is some bins off the start and short of the end of the transform
+    const uint32_t gate_start = 3;
+    const uint32_t gated_bins = test.full_bins / 2;
+
+    vector<vector<ifx_Complex_t>> gated_data(test.num_antennas, vector<ifx_Complex_t>(test.num_chirps * gated_bins));
+    vector<ifx_Matrix_C_t> gated(test.num_antennas);
+    vector<const ifx_Matrix_C_t*> gated_pointers(test.num_antennas);
+
+    for (uint32_t antenna = 0; antenna < test.num_antennas; ++antenna)
+    {
+        gated[antenna] = {test.num_chirps, gated_bins, gated_data[antenna].data()};
+        gated_pointers[antenna] = &gated[antenna];
+
+        vector<ifx_Complex_t> full_data = random_complex(test.num_chirps * test.full_bins);
+        ifx_Matrix_C_t full = {test.num_chirps, test.full_bins, full_data.data()};
+        kernel->gate(&full, gate_start, &gated[antenna]);
+
+        for (uint32_t chirp = 0; chirp < test.num_chirps; ++chirp)
+        {
+            for (uint32_t bin = 0; bin < gated_bins; ++bin)
+            {
+                if (!same(gated_data[antenna][chirp * gated_bins + bin], full_data[chirp * test.full_bins + gate_start + bin]))
+                {
+                    cerr << name << ": gate differs at antenna " << antenna << " chirp " << chirp << " bin " << bin << endl;
+                    ok = false;
+                    chirp = test.num_chirps;
+                    break;
+                }
+            }
+        }
+    }
+
+    vector<vector<ifx_Float_t>> spectra_data(test.num_antennas, vector<ifx_Float_t>(gated_bins));
+    vector<ifx_Vector_R_t> spectra(test.num_antennas);
+    vector<const ifx_Vector_R_t*> spectra_pointers(test.num_antennas);
+
+    for (uint32_t antenna = 0; antenna < test.num_antennas; ++antenna)
+    {
+        for (ifx_Float_t& value : spectra_data[antenna])
+        {
+            value = random_value();
+        }
+        spectra[antenna] = {gated_bins, spectra_data[antenna].data()};
+        spectra_pointers[antenna] = &spectra[antenna];
+    }
+
+    vector<ifx_Float_t> mean_data(gated_bins);
+    ifx_Vector_R_t mean = {gated_bins, mean_data.data()};
+    kernel->mean_spectrum(spectra_pointers.data(), &mean);
+
+    for (uint32_t bin = 0; bin < gated_bins; ++bin)
+    {
+        float expected = 0.0f;
+        for (uint32_t antenna = 0; antenna < test.num_antennas; ++antenna)
+        {
+            expected += spectra_data[antenna][bin];
+        }
+        expected /= test.num_antennas;
+
+        if (!near(mean_data[bin], expected))
+        {
+            cerr << name << ": mean_spectrum differs at bin " << bin << endl;
+            ok = false;
+            break;
+        }
+    }
+
+    vector<float> window(test.num_chirps);
+    for (uint32_t chirp = 0; chirp < test.num_chirps; ++chirp)
+    {
+        window[chirp] = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * chirp / (test.num_chirps - 1));
+    }
+
+    vector<ifx_Complex_t> input(test.num_chirps);
+
+    for (uint32_t bin = 0; bin < gated_bins; ++bin)
+    {
+        ifx_Complex_t expected_sum = {0};
+        for (uint32_t antenna = 0; antenna < test.num_antennas; ++antenna)
+        {
+            expected_sum.data[REAL] += gated_data[antenna][bin].data[REAL];
+            expected_sum.data[IMAG] += gated_data[antenna][bin].data[IMAG];
+        }
+
+        if (!same(kernel->antenna_sum(gated_pointers.data(), bin), expected_sum))
+        {
+            cerr << name << ": antenna_sum differs at bin " << bin << endl;
+            ok = false;
+            break;
+        }
+
+        kernel->doppler_input(&gated[0], bin, window.data(), input.data());
+
+        for (uint32_t chirp = 0; chirp < test.num_chirps; ++chirp)
+        {
+            const ifx_Complex_t element = gated_data[0][chirp * gated_bins + bin];
+            ifx_Complex_t expected;
+            expected.data[REAL] = element.data[REAL] * window[chirp];
+            expected.data[IMAG] = element.data[IMAG] * window[chirp];
+
+            if (!same(input[chirp], expected))
+            {
+                cerr << name << ": doppler_input differs at bin " << bin << " chirp " << chirp << endl;
+                ok = false;
+                bin = gated_bins;
+                break;
+            }
+        }
+    }
+
+    // Random values have a power of at most 2, so a 4 is the peak wherever it is put
+    vector<ifx_Complex_t> spectrum = random_complex(2 * test.num_chirps);
+    const uint32_t peaks[] = {0, 2 * test.num_chirps - 1, test.num_chirps / 3};
+
+    for (uint32_t peak : peaks)
+    {
+        vector<ifx_Complex_t> peaked = spectrum;
+        peaked[peak].data[REAL] = 4.0f;
+
+        uint32_t found = kernel->doppler_peak(peaked.data());
+        if (found != peak)
+        {
+            cerr << name << ": doppler_peak found " << found << " instead of " << peak << endl;
+            ok = false;
+        }
+    }
+
+    // Of two equal peaks the first wins
+    vector<ifx_Complex_t> tied = spectrum;
+    tied[5].data[REAL] = 4.0f;
+    tied[5].data[IMAG] = 0.0f;
+    tied[7] = tied[5];
+
+    if (kernel->doppler_peak(tied.data()) != 5)
+    {
+        cerr << name << ": doppler_peak doesn't keep the first of two equal peaks" << endl;
+        ok = false;
+    }
+
+    delete kernel;
+
+    cout << name << (test.specialised ? " (specialised)" : " (generic)") << (ok ? ": ok" : ": FAILED") << endl;
+    return ok;
+}
+
+int main()
+{
+    vector<check_case_t> tests;
+
+    // Every fleet profile, with the transform as wide as half the samples and zero padded to twice that
+#define KERNEL_CHECK_PROFILE(samples, chirps, antennas) \
+    tests.push_back({samples, chirps, antennas, samples / 2, true}); \
+    tests.push_back({samples, chirps, antennas, samples, true});
+
+    DSP_KERNEL_PROFILES(KERNEL_CHECK_PROFILE)
+
+    // Sizes that are in no profile, and one that is only off by the antennas
+    tests.push_back({96, 16, 2, 48, false});
+    tests.push_back({96, 16, 2, 128, false});
+    tests.push_back({128, 64, 1, 64, false});
+
+    bool ok = true;
+    for (const check_case_t& test : tests)
+    {
+        ok = check(test) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+#include "packet.hpp"
+#include "shm_ring.hpp"
+#include "udp_reassembler.hpp"
+
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+using namespace std;
+
+// Missing messages older than this are counted as lost for good
+#define LATENCY_PROBE_REORDER_WINDOW 1024
+
+// How long a blocking receive waits before stats and ctrl-c get a look in
+#define LATENCY_PROBE_POLL_MS 200
+
+bool running = true;
+
+void signal_handle(int sig)
+{
+    if (sig != SIGINT)
+        return;
+
+    running = false;
+}
+
+typedef struct
+{
+    uint64_t frames = 0;
+    uint64_t lost = 0;
+    uint64_t reordered = 0;
+    uint64_t duplicates = 0;
+    uint64_t restarts = 0;
+
+    // Next message number expected, and the ones skipped over that may still come late
+    uint32_t expected = 0;
+    std::set<uint32_t> missing;
+
+    // Smallest receive - send seen, the clock offset when sender and receiver clocks differ
+    int64_t min_transit_us = INT64_MAX;
+
+    // Per interval, in us
+    std::vector<int64_t> dsp;
+    std::vector<int64_t> queue;
+    std::vector<int64_t> transit;
+    std::vector<int64_t> total;
+} probe_stats_t;
+
+void track_message(probe_stats_t* stats, uint32_t message)
+{
+    if (stats->expected == 0 || message == stats->expected)
+    {
+        stats->expected = message + 1;
+    }
+    else if (message > stats->expected)
+    {
+        // Too far behind to still come, only the last window is waited for
+        uint32_t first = message - stats->expected > LATENCY_PROBE_REORDER_WINDOW ? message - LATENCY_PROBE_REORDER_WINDOW : stats->expected;
+        stats->lost += first - stats->expected;
+
+        for (uint32_t skipped = first; skipped < message; ++skipped)
+        {
+            stats->missing.insert(skipped);
+        }
+        stats->expected = message + 1;
+    }
+    else if (stats->expected - message > LATENCY_PROBE_REORDER_WINDOW)
+    {
+        // Further back than anything still waited for, the radar started counting again
+        stats->lost += stats->missing.size();
+        stats->missing.clear();
+        stats->expected = message + 1;
+        ++stats->restarts;
+    }
+    else if (stats->missing.erase(message) > 0)
+    {
+        ++stats->reordered;
+    }
+    else
+    {
+        ++stats->duplicates;
+    }
+
+    // Whatever fell out of the window isn't coming any more
+    while (!stats->missing.empty() && stats->expected - *stats->missing.begin() > LATENCY_PROBE_REORDER_WINDOW)
+    {
+        stats->missing.erase(stats->missing.begin());
+        ++stats->lost;
+    }
+}
+
+// One binary message, all packets of a frame or the config
+void handle_message(probe_stats_t* stats, const uint8_t* message, size_t length, uint64_t receive_us, bool same_clock)
+{
+    packet_header_t header;
+    if (length < sizeof(header))
+    {
+        return;
+    }
+    memcpy(&header, message, sizeof(header));
+
+    if (header.magic != PACKET_MAGIC || header.version != PACKET_VERSION || header.type == PACKET_TYPE_CONFIG)
+    {
+        return;
+    }
+
+    ++stats->frames;
+    track_message(stats, header.message);
+
+    int64_t send_time_us = (int64_t) (header.timestamp_us + header.send_us);
+    int64_t transit_us = (int64_t) receive_us - send_time_us;
+
+    // Without a shared clock only the spread above the fastest frame means anything
+    if (!same_clock)
+    {
+        stats->min_transit_us = std::min(stats->min_transit_us, transit_us);
+        transit_us -= stats->min_transit_us;
+    }
+
+    stats->dsp.push_back(header.dsp_done_us);
+    stats->queue.push_back((int64_t) header.send_us - header.dsp_done_us);
+    stats->transit.push_back(transit_us);
+    stats->total.push_back((int64_t) header.send_us + transit_us);
+}
+
+void print_percentiles(const char* name, std::vector<int64_t>* samples)
+{
+    if (samples->empty())
+    {
+        return;
+    }
+
+    std::sort(samples->begin(), samples->end());
+
+    size_t n = samples->size();
+    cout << "  " << name << ": p50 " << (*samples)[n / 2] << " us, p90 " << (*samples)[n * 9 / 10]
+         << " us, p99 " << (*samples)[n * 99 / 100] << " us, max " << samples->back() << " us" << endl;
+
+    samples->clear();
+}
+
+void print_stats(probe_stats_t* stats, double seconds, bool same_clock)
+{
+    cout << stats->frames / seconds << " frames/s, lost " << stats->lost << " (+" << stats->missing.size() << " pending), reordered "
+         << stats->reordered << ", duplicate " << stats->duplicates << ", restarts " << stats->restarts << endl;
+
+    print_percentiles("dsp      ", &stats->dsp);
+    print_percentiles("queue    ", &stats->queue);
+    print_percentiles(same_clock ? "transit  " : "transit* ", &stats->transit);
+    print_percentiles(same_clock ? "total    " : "total*   ", &stats->total);
+
+    stats->frames = 0;
+}
+
+int main(int argc, char* argv[])
+{
+    string transport;
+    uint16_t port;
+    string group;
+    string shm_name;
+    uint32_t interval_s;
+    bool remote;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("transport", po::value<string>(&transport)->default_value("tcp"),
+            "tcp accepts the radar as its server, udp receives its stream, shm reads its ring")
+        ("port,p", po::value<uint16_t>(&port)->default_value(4242), "tcp / udp port")
+        ("group,g", po::value<string>(&group), "udp multicast group to join")
+        ("shm-name", po::value<string>(&shm_name)->default_value(SHM_RING_DEFAULT_NAME), "shared memory ring to read")
+        ("interval", po::value<uint32_t>(&interval_s)->default_value(5), "seconds between reports")
+        ("remote", po::bool_switch(&remote), "the radar runs on another host, transit is then relative to the fastest frame (marked *)");
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (vm.count("help"))
+    {
+        cout << "Usage: ./radar_latency_probe [options]" << endl
+             << "Needs the binary encoding. Stages: dsp is acquisition to dsp done, queue is dsp done to the" << endl
+             << "transport writing, transit is writing to receiving, total is acquisition to receiving." << endl
+             << options << endl;
+        return 0;
+    }
+
+    signal(SIGINT, signal_handle);
+
+    bool same_clock = !remote;
+
+    probe_stats_t stats;
+
+    boost::asio::io_service io_service;
+    boost::system::error_code error;
+
+    // Only one of these is used
+    tcp::socket tcp_socket(io_service);
+    udp::socket udp_socket(io_service);
+    shm_ring_reader* ring = nullptr;
+    udp_reassembler reassembler;
+
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = LATENCY_PROBE_POLL_MS * 1000;
+
+    if (transport == "tcp")
+    {
+        tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port), true);
+
+        cout << "Waiting for the radar on port " << port << endl;
+        acceptor.accept(tcp_socket, error);
+
+        if (error)
+        {
+            cerr << "Accept failed: " << error.message() << endl;
+            return 1;
+        }
+    }
+    else if (transport == "udp")
+    {
+        udp_socket.open(udp::v4(), error);
+        udp_socket.set_option(boost::asio::socket_base::reuse_address(true), error);
+        udp_socket.set_option(boost::asio::socket_base::receive_buffer_size(4 * 1024 * 1024), error);
+        udp_socket.bind(udp::endpoint(udp::v4(), port), error);
+
+        if (!error && !group.empty())
+        {
+            udp_socket.set_option(boost::asio::ip::multicast::join_group(boost::asio::ip::address::from_string(group).to_v4()), error);
+        }
+
+        if (error)
+        {
+            cerr << "Can't receive on port " << port << ": " << error.message() << endl;
+            return 1;
+        }
+
+        setsockopt(udp_socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    else if (transport == "shm")
+    {
+        ring = new shm_ring_reader(shm_name);
+
+        string open_error;
+        if (!ring->open(&open_error))
+        {
+            cerr << open_error << endl;
+            delete ring;
+            return 1;
+        }
+    }
+    else
+    {
+        cerr << "Unknown transport " << transport << endl;
+        return 1;
+    }
+
+    cout << "Receiving" << endl;
+
+    std::vector<uint8_t> datagram(65536);
+
+    // A tcp frame is collected packet by packet up to the one flagged last
+    std::vector<uint8_t> frame;
+
+    std::chrono::steady_clock::time_point last_print = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_message = last_print;
+
+    while (running)
+    {
+        if (transport == "tcp")
+        {
+            // Once something is there the whole packet is read blocking, a timeout could split it
+            struct pollfd readable = {tcp_socket.native_handle(), POLLIN, 0};
+
+            if (poll(&readable, 1, LATENCY_PROBE_POLL_MS) > 0)
+            {
+                packet_header_t header;
+                boost::asio::read(tcp_socket, boost::asio::buffer(&header, sizeof(header)), error);
+
+                if (!error && header.magic != PACKET_MAGIC)
+                {
+                    cerr << "Not a binary stream, start the radar with --encoding binary" << endl;
+                    break;
+                }
+
+                if (!error)
+                {
+                    size_t offset = frame.size();
+                    frame.resize(offset + sizeof(header) + header.payload_length);
+                    memcpy(frame.data() + offset, &header, sizeof(header));
+
+                    boost::asio::read(tcp_socket, boost::asio::buffer(frame.data() + offset + sizeof(header), header.payload_length), error);
+                }
+
+                if (error)
+                {
+                    cerr << "Connection closed: " << error.message() << endl;
+                    break;
+                }
+
+                if (header.flags & PACKET_FLAG_LAST_OF_FRAME)
+                {
+                    handle_message(&stats, frame.data(), frame.size(), packet_time_us(), same_clock);
+                    frame.clear();
+                }
+            }
+        }
+        else if (transport == "udp")
+        {
+            udp::endpoint sender;
+            size_t length = udp_socket.receive_from(boost::asio::buffer(datagram), sender, 0, error);
+
+            if (!error && reassembler.add(datagram.data(), length))
+            {
+                handle_message(&stats, reassembler.get_message(), reassembler.get_message_length(), packet_time_us(), same_clock);
+            }
+        }
+        else
+        {
+            const uint8_t* message;
+            size_t length;
+
+            shm_ring_status_t status = ring->next(&message, &length, LATENCY_PROBE_POLL_MS);
+
+            bool stale = status == SHM_RING_TIMEOUT &&
+                         std::chrono::steady_clock::now() - last_message > std::chrono::milliseconds(SHM_RING_STALE_MS);
+
+            // The radar restarted, its new ring is read from the start again
+            if (status == SHM_RING_CLOSED || (stale && ring->replaced()))
+            {
+                cout << "Ring closed or replaced, reopening" << endl;
+
+                string open_error;
+                while (running && !ring->open(&open_error))
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(LATENCY_PROBE_POLL_MS));
+                }
+
+                last_message = std::chrono::steady_clock::now();
+            }
+
+            if (status == SHM_RING_OK)
+            {
+                uint64_t receive_us = packet_time_us();
+                last_message = std::chrono::steady_clock::now();
+
+                // The header is copied out first, it only counts if the writer didn't lap us meanwhile
+                uint8_t header[sizeof(packet_header_t)];
+                size_t header_length = std::min(length, sizeof(header));
+                memcpy(header, message, header_length);
+
+                if (ring->validate())
+                {
+                    handle_message(&stats, header, header_length, receive_us, same_clock);
+                }
+            }
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_print).count();
+
+        if (seconds >= interval_s)
+        {
+            print_stats(&stats, seconds, same_clock);
+            last_print = now;
+        }
+    }
+
+    delete ring;
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include "shm_ring.hpp"
+#include "packet.hpp"
+#include "json.hpp"
+
+#include <signal.h>
+#include <string.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using json = nlohmann::json;
+using namespace std;
+
+bool running = true;
+
+void signal_handle(int sig)
+{
+    if (sig != SIGINT)
+        return;
+
+    running = false;
+}
+
+// The config is JSON text in every encoding, as a CONFIG packet or as a length prefixed document
+bool read_config(const uint8_t* message, size_t length, json* config)
+{
+    const char* text = nullptr;
+    size_t text_length = 0;
+
+    packet_header_t header;
+    if (length >= sizeof(header))
+    {
+        memcpy(&header, message, sizeof(header));
+
+        if (header.magic == PACKET_MAGIC && header.type == PACKET_TYPE_CONFIG && sizeof(header) + header.payload_length <= length)
+        {
+            text = (const char*) message + sizeof(header);
+            text_length = header.payload_length;
+        }
+    }
+
+    if (text == nullptr && length > 4 && message[4] == '{')
+    {
+        text = (const char*) message + 4;
+        text_length = length - 4;
+    }
+
+    if (text == nullptr)
+    {
+        return false;
+    }
+
+    *config = json::parse(text, text + text_length, nullptr, false);
+
+    return !config->is_discarded() && config->value("packet_type", "") == "configuration";
+}
+
+// Walks the packets of a binary message in place, only counts them
+uint32_t count_packets(const uint8_t* message, size_t length)
+{
+    uint32_t packets = 0;
+    size_t offset = 0;
+
+    packet_header_t header;
+    while (offset + sizeof(header) <= length)
+    {
+        memcpy(&header, message + offset, sizeof(header));
+
+        if (header.magic != PACKET_MAGIC)
+        {
+            break;
+        }
+
+        ++packets;
+        offset += sizeof(header) + header.payload_length;
+    }
+
+    return packets;
+}
+
+// The writer may not be up yet, or is being restarted
+bool open_ring(shm_ring_reader* reader)
+{
+    string error;
+    while (!reader->open(&error))
+    {
+        if (!running)
+        {
+            return false;
+        }
+
+        cerr << error << ", retrying" << endl;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    string name;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("name,n", po::value<string>(&name)->default_value(SHM_RING_DEFAULT_NAME), "shared memory ring to read");
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (vm.count("help"))
+    {
+        cout << "Usage: ./radar_shm_reader [options]" << endl << options << endl;
+        return 0;
+    }
+
+    signal(SIGINT, signal_handle);
+
+    shm_ring_reader reader(name);
+
+    if (!open_ring(&reader))
+    {
+        return 0;
+    }
+
+    cout << "Reading ring " << name << endl;
+
+    bool have_config = false;
+
+    uint64_t messages = 0;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t torn = 0;
+
+    std::chrono::steady_clock::time_point last_print = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_message = last_print;
+
+    while (running)
+    {
+        const uint8_t* message;
+        size_t length;
+
+        // Wake up regularly so stats get printed and ctrl-c is noticed without traffic
+        shm_ring_status_t status = reader.next(&message, &length, 200);
+
+        bool stale = status == SHM_RING_TIMEOUT &&
+                     std::chrono::steady_clock::now() - last_message > std::chrono::milliseconds(SHM_RING_STALE_MS);
+
+        if (status == SHM_RING_CLOSED || (stale && reader.replaced()))
+        {
+            cout << (status == SHM_RING_CLOSED ? "Writer closed the ring" : "Ring was replaced") << ", reopening" << endl;
+
+            if (!open_ring(&reader))
+            {
+                break;
+            }
+
+            // The new writer sends its own config
+            have_config = false;
+            last_message = std::chrono::steady_clock::now();
+        }
+
+        if (status == SHM_RING_OK)
+        {
+            last_message = std::chrono::steady_clock::now();
+
+            json config;
+            bool is_config = !have_config && read_config(message, length, &config);
+
+            uint32_t message_packets = count_packets(message, length);
+
+            // Whatever was read from a message that got overwritten meanwhile is thrown away
+            if (!reader.validate())
+            {
+                ++torn;
+            }
+            else
+            {
+                if (is_config)
+                {
+                    cout << "Got config, sdk " << config.value("sdk_version", "?")
+                         << ", encoding " << config.value("encoding", "?") << endl;
+                    have_config = true;
+                }
+
+                ++messages;
+                packets += message_packets;
+                bytes += length;
+            }
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_print).count();
+
+        if (seconds >= 1.0)
+        {
+            cout << messages / seconds << " msg/s, "
+                 << packets / seconds << " packets/s, "
+                 << bytes * 8 / seconds / 1e6 << " Mbit/s, "
+                 << "lost " << reader.get_lost() << ", torn " << torn << endl;
+
+            messages = 0;
+            packets = 0;
+            bytes = 0;
+            last_print = now;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "udp_reassembler.hpp"
+#include "packet.hpp"
+#include "json.hpp"
+
+#include <signal.h>
+#include <string.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+using boost::asio::ip::udp;
+using json = nlohmann::json;
+using namespace std;
+
+bool running = true;
+
+void signal_handle(int sig)
+{
+    if (sig != SIGINT)
+        return;
+
+    running = false;
+}
+
+// The config is JSON text in every encoding, as a CONFIG packet or as a length prefixed document
+bool read_config(const uint8_t* message, size_t length, json* config)
+{
+    const char* text = nullptr;
+    size_t text_length = 0;
+
+    packet_header_t header;
+    if (length >= sizeof(header))
+    {
+        memcpy(&header, message, sizeof(header));
+
+        if (header.magic == PACKET_MAGIC && header.type == PACKET_TYPE_CONFIG && sizeof(header) + header.payload_length <= length)
+        {
+            text = (const char*) message + sizeof(header);
+            text_length = header.payload_length;
+        }
+    }
+
+    if (text == nullptr && length > 4 && message[4] == '{')
+    {
+        text = (const char*) message + 4;
+        text_length = length - 4;
+    }
+
+    if (text == nullptr)
+    {
+        return false;
+    }
+
+    *config = json::parse(text, text + text_length, nullptr, false);
+
+    return !config->is_discarded() && config->value("packet_type", "") == "configuration";
+}
+
+void print_stats(const udp_reassembler_stats_t& stats, const udp_reassembler_stats_t& last, double seconds)
+{
+    uint64_t messages = stats.messages - last.messages;
+    uint64_t missing = (stats.lost_messages - last.lost_messages) + (stats.incomplete_messages - last.incomplete_messages);
+
+    cout << messages / seconds << " msg/s, "
+         << (stats.bytes - last.bytes) * 8 / seconds / 1e6 << " Mbit/s, "
+         << "lost " << stats.lost_messages << ", incomplete " << stats.incomplete_messages << " ("
+         << (messages + missing > 0 ? 100.0 * missing / (messages + missing) : 0.0) << " %), "
+         << "duplicate " << stats.duplicate_fragments << ", late " << stats.late_fragments
+         << ", invalid " << stats.invalid_datagrams << ", restarts " << stats.restarts << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    uint16_t port;
+    string group;
+    string interface_address;
+
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("port,p", po::value<uint16_t>(&port)->default_value(4242), "port the streamer sends to")
+        ("group,g", po::value<string>(&group), "multicast group to join, leave out for unicast")
+        ("interface", po::value<string>(&interface_address)->default_value("0.0.0.0"), "local address to join the group on");
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    }
+    catch (const po::error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (vm.count("help"))
+    {
+        cout << "Usage: ./radar_udp_receiver [options]" << endl << options << endl;
+        return 0;
+    }
+
+    signal(SIGINT, signal_handle);
+
+    boost::asio::io_service io_service;
+    udp::socket socket(io_service);
+
+    boost::system::error_code error;
+
+    socket.open(udp::v4(), error);
+    socket.set_option(boost::asio::socket_base::reuse_address(true), error);
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(4 * 1024 * 1024), error);
+    socket.bind(udp::endpoint(udp::v4(), port), error);
+
+    if (error)
+    {
+        cerr << "Can't listen on port " << port << ": " << error.message() << endl;
+        return 1;
+    }
+
+    if (!group.empty())
+    {
+        socket.set_option(boost::asio::ip::multicast::join_group(boost::asio::ip::address::from_string(group).to_v4(),
+                                                                 boost::asio::ip::address::from_string(interface_address).to_v4()), error);
+        if (error)
+        {
+            cerr << "Can't join " << group << ": " << error.message() << endl;
+            return 1;
+        }
+    }
+
+    // Wake up regularly so stats get printed and ctrl-c is noticed without traffic
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 200 * 1000;
+    setsockopt(socket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    cout << "Listening on port " << port << (group.empty() ? "" : " in group " + group) << endl;
+
+    udp_reassembler reassembler;
+    udp_reassembler_stats_t last_stats = reassembler.get_stats();
+
+    std::vector<uint8_t> datagram(65536);
+    bool have_config = false;
+
+    std::chrono::steady_clock::time_point last_print = std::chrono::steady_clock::now();
+
+    while (running)
+    {
+        udp::endpoint sender;
+        size_t length = socket.receive_from(boost::asio::buffer(datagram), sender, 0, error);
+
+        if (!error && reassembler.add(datagram.data(), length) && !have_config)
+        {
+            json config;
+            if (read_config(reassembler.get_message(), reassembler.get_message_length(), &config))
+            {
+                cout << "Got config from " << sender << ", sdk " << config.value("sdk_version", "?")
+                     << ", encoding " << config.value("encoding", "?") << endl;
+                have_config = true;
+            }
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_print).count();
+
+        if (seconds >= 1.0)
+        {
+            udp_reassembler_stats_t stats = reassembler.get_stats();
+            print_stats(stats, last_stats, seconds);
+
+            last_stats = stats;
+            last_print = now;
+        }
+    }
+
+    return 0;
+}